@@ -35,6 +35,7 @@ endif()
 #-------------------------------------------------------------------------------
 option(REBUILD_SHADER "Rebuild GLSL/CG shader (developer option)")
 option(BUILD_REPLAY_LOADERS "Build GS replayer to ease testing (developer option)")
+option(BUILD_BENCHMARK "Build the headless benchmark runner for the libretro core (developer option)")
 
 #-------------------------------------------------------------------------------
 # Path and lib option
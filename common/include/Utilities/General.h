@@ -212,6 +212,12 @@ extern void MemProtect(void *baseaddr, size_t size, const PageProtectionMode &mo
 
 extern void Munmap(void *base, size_t size);
 
+// Shared memory lets the same pages be mapped at more than one host address (used by the
+// EE fastmem views).  Only implemented on Linux; CreateSharedMemory returns NULL elsewhere.
+extern void *CreateSharedMemory(size_t size);
+extern void DestroySharedMemory(void *handle);
+extern bool MapSharedMemory(void *handle, size_t offset, void *baseaddr, size_t size, const PageProtectionMode &mode);
+
 template <uint size>
 void MemProtectStatic(u8 (&arr)[size], const PageProtectionMode &mode)
 {
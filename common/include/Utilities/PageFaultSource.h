@@ -31,9 +31,14 @@ struct PageFaultInfo
 {
     uptr addr;
 
-    PageFaultInfo(uptr address)
+    // Instruction pointer slot of the faulting thread's saved context, or NULL if the
+    // platform doesn't provide it.  Listeners may redirect execution by writing to it.
+    uptr *pc;
+
+    PageFaultInfo(uptr address, uptr *pc_ = NULL)
     {
         addr = address;
+        pc = pc_;
     }
 };
 
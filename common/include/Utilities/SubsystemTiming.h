@@ -0,0 +1,106 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#include "Pcsx2Types.h"
+#include <atomic>
+
+// Also included by the GS plugin, so don't pull in Pcsx2Defs.h here.
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// --------------------------------------------------------------------------------------
+//  SubsystemTiming
+// --------------------------------------------------------------------------------------
+// Always-on accounting of where each emulator thread spends its time, in TSC ticks.
+// Every thread has a "current" counter that its time is charged to; switching counters
+// charges the ticks since the last switch to the old one.  Nested scopes therefore count
+// exclusive time: SPU2 mixing done from IOP code shows up as SPU2, not as IOP.
+//
+// A switch costs two TSC reads and a relaxed atomic add, no locks, so the counters are
+// cheap enough to stay enabled in release builds.  Threads that are not instrumented
+// charge to None, which is never reported.
+//
+namespace SubsystemTiming
+{
+	enum Counter
+	{
+		None = 0,
+		EE,        // EE recompiler/interpreter execution
+		EEWait,    // EE blocked on the MTGS, the MTVU or the frontend
+		IOP,       // IOP execution and IOP event tests
+		VU1Busy,   // MTVU thread processing its ring
+		VU1Idle,   // MTVU thread waiting for work
+		VU1WaitGS, // MTVU thread blocked on the MTGS ring (XGKICK syncs)
+		MTGS,      // MTGS ring processing (includes the GS renderer)
+		GSWorkers, // software rasterizer worker threads, summed over all workers
+		SPU2,      // SPU2 mixing
+		CDVDWait,  // waiting on disc image reads
+		CounterCount
+	};
+
+	struct alignas(64) Total
+	{
+		std::atomic<u64> ticks;
+		std::atomic<u64> calls;
+	};
+
+	struct ThreadState
+	{
+		Counter current;
+		u64 since;
+	};
+
+	extern Total g_totals[CounterCount];
+	extern const char* const g_names[CounterCount];
+	extern thread_local ThreadState t_state;
+
+	static inline u64 Now() { return __rdtsc(); }
+
+	// Charges the time since the last switch to the current counter and makes 'next' the
+	// current one.  Returns the previous counter.
+	static inline Counter Switch(Counter next)
+	{
+		ThreadState& state = t_state;
+		const u64 now = Now();
+		g_totals[state.current].ticks.fetch_add(now - state.since, std::memory_order_relaxed);
+		const Counter prev = state.current;
+		state.current = next;
+		state.since = now;
+		return prev;
+	}
+
+	// Charges the enclosed code to 'counter' and counts one call.  Code that can longjmp out
+	// of a scope must switch the thread back explicitly (see SysCoreThread).
+	class Scope
+	{
+		Counter m_prev;
+
+	public:
+		Scope(Counter counter)
+			: m_prev(Switch(counter))
+		{
+			g_totals[counter].calls.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		~Scope() { Switch(m_prev); }
+	};
+
+	// Copies the running totals (any thread).
+	void Snapshot(u64 ticks[CounterCount], u64 calls[CounterCount]);
+} // namespace SubsystemTiming
@@ -125,6 +125,9 @@ extern void SpinWait();
 // sleeps the current thread for the given number of milliseconds.
 extern void Sleep(int ms);
 
+// Names the calling thread for the OS (debuggers, top, /proc/<pid>/task/<tid>/comm).
+extern void SetNameOfCurrentThread(const char* name);
+
 class Semaphore
 {
 protected:
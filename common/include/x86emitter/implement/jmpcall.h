@@ -43,6 +43,7 @@ struct xImpl_JmpCall
             sptr dest = (sptr)func - ((sptr)xGetPtr() + 5);
             xWrite8(0xe8);
             xWrite32(dest);
+            xRecordReloc(xReloc_Rel32, 4);
         }
     }
 };
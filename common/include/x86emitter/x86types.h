@@ -39,6 +39,7 @@ enum XMMSSEType {
 // TLS -- Macs are crap out of luck there (for now).
 
 #include "Utilities/Threading.h"
+#include <vector>
 
 #ifndef x86EMIT_MULTITHREADED
 #if PCSX2_THREAD_LOCAL
@@ -65,6 +66,30 @@ enum XMMSSEType {
 extern __tls_emit u8 *x86Ptr;
 extern __tls_emit XMMSSEType g_xmmtypes[iREGCNT_XMM];
 
+// --------------------------------------------------------------------------------------
+//  xRelocLog
+// --------------------------------------------------------------------------------------
+// While xRelocLog is set, the emitter records every field it writes that holds an address or
+// a displacement, so that a piece of code can be copied somewhere else and fixed up (see
+// RecBlockCache).  Fields patched afterwards (forward jumps, links) keep their site, and their
+// final value is read back once the code is complete.
+//
+enum xRelocType {
+    xReloc_Rel8,  // 8 bit jump displacement
+    xReloc_Rel32, // 32 bit jump/call displacement or rip-relative operand
+    xReloc_Abs32, // absolute 32 bit operand, only used for addresses below 2GB
+    xReloc_Abs64, // 64 bit immediate
+};
+
+struct xRelocSite
+{
+    u8 *site;  // the field
+    u8 type;   // xRelocType
+    u8 extra;  // rip-relative operands: bytes of the instruction that follow the field
+};
+
+extern __tls_emit std::vector<xRelocSite> *xRelocLog;
+
 namespace x86Emitter
 {
 
@@ -73,6 +98,13 @@ extern void xWrite16(u16 val);
 extern void xWrite32(u32 val);
 extern void xWrite64(u64 val);
 
+// Records the field of the given type that was just written, if xRelocLog is set.
+static __fi void xRecordReloc(xRelocType type, int size, int extra = 0)
+{
+    if (xRelocLog)
+        xRelocLog->push_back({x86Ptr - size, (u8)type, (u8)extra});
+}
+
 extern const char *xGetRegName(int regid, int operandSize);
 
 //------------------------------------------------------------------
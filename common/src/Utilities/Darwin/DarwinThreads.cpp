@@ -43,4 +43,9 @@ __forceinline void Threading::SpinWait()
     // performance hint and isn't required).
     __asm__("pause");
 }
+
+void Threading::SetNameOfCurrentThread(const char* name)
+{
+    pthread_setname_np(name);
+}
 #endif
@@ -21,6 +21,9 @@
 
 #include <sys/mman.h>
 #include <signal.h>
+#ifdef __linux__
+#include <ucontext.h>
+#endif
 #include <errno.h>
 #include <unistd.h>
 
@@ -35,7 +38,7 @@ extern void SignalExit(int sig);
 static const uptr m_pagemask = getpagesize() - 1;
 
 // Linux implementation of SIGSEGV handler.  Bind it using sigaction().
-static void SysPageFaultSignalFilter(int signal, siginfo_t *siginfo, void *)
+static void SysPageFaultSignalFilter(int signal, siginfo_t *siginfo, void *context)
 {
     // [TODO] : Add a thread ID filter to the Linux Signal handler here.
     // Rationale: On windows, the __try/__except model allows per-thread specific behavior
@@ -59,7 +62,12 @@ static void SysPageFaultSignalFilter(int signal, siginfo_t *siginfo, void *)
     // so for now we lock this exception code unless someone can fix this better...
     Threading::ScopedLock lock(PageFault_Mutex);
 
-    Source_PageFault->Dispatch(PageFaultInfo((uptr)siginfo->si_addr & ~m_pagemask));
+    uptr *pc = NULL;
+#if defined(__linux__) && defined(__x86_64__)
+    pc = (uptr *)&((ucontext_t *)context)->uc_mcontext.gregs[REG_RIP];
+#endif
+
+    Source_PageFault->Dispatch(PageFaultInfo((uptr)siginfo->si_addr & ~m_pagemask, pc));
 
     // resumes execution right where we left off (re-executes instruction that
     // caused the SIGSEGV).
@@ -172,3 +180,52 @@ void HostSys::MemProtect(void *baseaddr, size_t size, const PageProtectionMode &
             "mprotect failed @ 0x%08X -> 0x%08X  (mode=%s)\n",
                                baseaddr, (uptr)baseaddr + size, WX_STR(mode.ToString()));
 }
+
+#ifdef __linux__
+void *HostSys::CreateSharedMemory(size_t size)
+{
+    int fd = memfd_create("pcsx2", MFD_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    return (void *)(sptr)fd;
+}
+
+void HostSys::DestroySharedMemory(void *handle)
+{
+    if (handle)
+        close((int)(sptr)handle);
+}
+
+bool HostSys::MapSharedMemory(void *handle, size_t offset, void *baseaddr, size_t size, const PageProtectionMode &mode)
+{
+    uint lnxmode = 0;
+
+    if (mode.CanWrite())
+        lnxmode |= PROT_WRITE;
+    if (mode.CanRead())
+        lnxmode |= PROT_READ;
+
+    void *result = mmap(baseaddr, size, lnxmode, MAP_SHARED | MAP_FIXED, (int)(sptr)handle, offset);
+    return result == baseaddr;
+}
+#else
+void *HostSys::CreateSharedMemory(size_t size)
+{
+    return NULL;
+}
+
+void HostSys::DestroySharedMemory(void *handle)
+{
+}
+
+bool HostSys::MapSharedMemory(void *handle, size_t offset, void *baseaddr, size_t size, const PageProtectionMode &mode)
+{
+    return false;
+}
+#endif
@@ -50,4 +50,15 @@ __forceinline void Threading::SpinWait()
     // performance hint and isn't required).
     __asm__("pause");
 }
+
+void Threading::SetNameOfCurrentThread(const char* name)
+{
+#if defined(__linux__)
+    // Extract of manpage: "The name can be up to 16 bytes long, and should be
+    //						null-terminated if it contains fewer bytes."
+    prctl(PR_SET_NAME, name, 0, 0, 0);
+#elif defined(__unix__)
+    pthread_set_name_np(pthread_self(), name);
+#endif
+}
 #endif
@@ -0,0 +1,49 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SubsystemTiming.h"
+
+namespace SubsystemTiming
+{
+	Total g_totals[CounterCount] = {};
+
+	const char* const g_names[CounterCount] =
+	{
+		"none",
+		"ee",
+		"ee_wait",
+		"iop",
+		"vu1_busy",
+		"vu1_idle",
+		"vu1_wait_gs",
+		"mtgs",
+		"gs_sw_workers",
+		"spu2_mix",
+		"cdvd_wait",
+	};
+
+	// 'since' starts at 0, so the first switch of a thread charges its whole lifetime so
+	// far to None, which is not reported.
+	thread_local ThreadState t_state = {None, 0};
+
+	void Snapshot(u64 ticks[CounterCount], u64 calls[CounterCount])
+	{
+		for (int i = 0; i < CounterCount; i++)
+		{
+			ticks[i] = g_totals[i].ticks.load(std::memory_order_relaxed);
+			calls[i] = g_totals[i].calls.load(std::memory_order_relaxed);
+		}
+	}
+} // namespace SubsystemTiming
@@ -502,6 +502,7 @@ void Threading::pxThread::_internal_execute()
     if (curthread_key)
         pthread_setspecific(curthread_key, this);
 
+    SetNameOfCurrentThread(m_name.ToUTF8());
     OnStartInThread();
     m_sem_startup.Post();
 
@@ -28,7 +28,12 @@ static long DoSysPageFaultExceptionFilter(EXCEPTION_POINTERS *eps)
     // Source_PageFault is a global variable with its own state information
     // so for now we lock this exception code unless someone can fix this better...
     Threading::ScopedLock lock(PageFault_Mutex);
-    Source_PageFault->Dispatch(PageFaultInfo((uptr)eps->ExceptionRecord->ExceptionInformation[1]));
+#ifdef _WIN64
+    uptr *pc = (uptr *)&eps->ContextRecord->Rip;
+#else
+    uptr *pc = (uptr *)&eps->ContextRecord->Eip;
+#endif
+    Source_PageFault->Dispatch(PageFaultInfo((uptr)eps->ExceptionRecord->ExceptionInformation[1], pc));
     return Source_PageFault->WasHandled() ? EXCEPTION_CONTINUE_EXECUTION : EXCEPTION_CONTINUE_SEARCH;
 }
 
@@ -139,3 +144,18 @@ void HostSys::MemProtect(void *baseaddr, size_t size, const PageProtectionMode &
              baseaddr, (uptr)baseaddr + size, mode.ToString().c_str());
     }
 }
+
+// Fastmem views are not implemented on Windows yet.
+void *HostSys::CreateSharedMemory(size_t size)
+{
+    return NULL;
+}
+
+void HostSys::DestroySharedMemory(void *handle)
+{
+}
+
+bool HostSys::MapSharedMemory(void *handle, size_t offset, void *baseaddr, size_t size, const PageProtectionMode &mode)
+{
+    return false;
+}
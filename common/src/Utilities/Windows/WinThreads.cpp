@@ -35,4 +35,22 @@ __fi void Threading::SpinWait()
 {
     _mm_pause();
 }
+
+// SetThreadDescription is only there since Windows 10 1607, so it's looked up at runtime;
+// older systems simply keep unnamed threads.
+void Threading::SetNameOfCurrentThread(const char* name)
+{
+    typedef HRESULT(WINAPI * SetThreadDescriptionFn)(HANDLE, PCWSTR);
+    static const SetThreadDescriptionFn set_description =
+        (SetThreadDescriptionFn)GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription");
+
+    if (!set_description)
+        return;
+
+    wchar_t wname[64];
+    if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wname, sizeof(wname) / sizeof(*wname)) == 0)
+        return;
+
+    set_description(GetCurrentThread(), wname);
+}
 #endif
@@ -141,6 +141,7 @@ __emitinline s32 *xJcc32(JccComparisonType comparison, s32 displacement)
         xWrite8(0x80 | comparison);
     }
     xWrite<s32>(displacement);
+    xRecordReloc(xReloc_Rel32, 4);
 
     return ((s32 *)xGetPtr()) - 1;
 }
@@ -153,6 +154,7 @@ __emitinline s8 *xJcc8(JccComparisonType comparison, s8 displacement)
 {
     xWrite8((comparison == Jcc_Unconditional) ? 0xeb : (0x70 | comparison));
     xWrite<s8>(displacement);
+    xRecordReloc(xReloc_Rel8, 1);
     return (s8 *)xGetPtr() - 1;
 }
 
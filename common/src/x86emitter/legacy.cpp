@@ -50,6 +50,7 @@ emitterT u8 *J8Rel(int cc, int to)
 {
     xWrite8(cc);
     xWrite8(to);
+    xRecordReloc(xReloc_Rel8, 1);
     return (u8 *)(x86Ptr - 1);
 }
 
@@ -66,13 +67,14 @@ emitterT u32 *J32Rel(int cc, u32 to)
     xWrite8(0x0F);
     xWrite8(cc);
     xWrite32(to);
+    xRecordReloc(xReloc_Rel32, 4);
     return (u32 *)(x86Ptr - 4);
 }
 
 ////////////////////////////////////////////////////
 emitterT void x86SetPtr(u8 *ptr)
 {
-    x86Ptr = ptr;
+    xSetPtr(ptr);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -147,6 +149,7 @@ emitterT u8 *JMP8(u8 to)
 {
     xWrite8(0xEB);
     xWrite8(to);
+    xRecordReloc(xReloc_Rel8, 1);
     return x86Ptr - 1;
 }
 
@@ -156,6 +159,7 @@ emitterT u32 *JMP32(uptr to)
     assert((sptr)to <= 0x7fffffff && (sptr)to >= -0x7fffffff);
     xWrite8(0xE9);
     xWrite32(to);
+    xRecordReloc(xReloc_Rel32, 4);
     return (u32 *)(x86Ptr - 4);
 }
 
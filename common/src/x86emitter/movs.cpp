@@ -114,10 +114,14 @@ void xImpl_MovImm64::operator()(const xRegister64& to, s64 imm, bool preserve_fl
 {
     if (imm == (u32)imm || imm == (s32)imm) {
         xMOV(to, imm, preserve_flags);
+        // only addresses are loaded this way, see xLoadFarAddr
+        if (imm != 0 || preserve_flags)
+            xRecordReloc(xReloc_Abs32, 4);
     } else {
         u8 opcode = 0xb8 | to.Id;
         xOpAccWrite(to.GetPrefix16(), opcode, 0, to);
         xWrite64(imm);
+        xRecordReloc(xReloc_Abs64, 8);
     }
 }
 
@@ -63,6 +63,7 @@
 
 __tls_emit u8 *x86Ptr;
 __tls_emit XMMSSEType g_xmmtypes[iREGCNT_XMM] = {XMMT_INT};
+__tls_emit std::vector<xRelocSite> *xRelocLog;
 
 namespace x86Emitter
 {
@@ -228,6 +229,7 @@ static __fi void SibSB(u32 ss, u32 index, u32 base)
 void EmitSibMagic(uint regfield, const void *address, int extraRIPOffset)
 {
     sptr displacement = (sptr)address;
+    xRelocType reloc = xReloc_Abs32;
 #ifndef __M_X86_64
     ModRM(0, regfield, ModRm_UseDisp32);
 #else
@@ -236,6 +238,7 @@ void EmitSibMagic(uint regfield, const void *address, int extraRIPOffset)
     if (ripRelative == (s32)ripRelative) {
         ModRM(0, regfield, ModRm_UseDisp32);
         displacement = ripRelative;
+        reloc = xReloc_Rel32;
     } else {
         ModRM(0, regfield, ModRm_UseSib);
         SibSB(0, Sib_EIZ, Sib_UseDisp32);
@@ -243,6 +246,7 @@ void EmitSibMagic(uint regfield, const void *address, int extraRIPOffset)
 #endif
 
     xWrite<s32>((s32)displacement);
+    xRecordReloc(reloc, 4, extraRIPOffset);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -452,6 +456,12 @@ void EmitRexImplicitlyWide(const xIndirectVoid &sib)
 __emitinline void xSetPtr(void *ptr)
 {
     x86Ptr = (u8 *)ptr;
+
+    // code being rewound drops the fields it recorded
+    if (xRelocLog) {
+        while (!xRelocLog->empty() && xRelocLog->back().site >= x86Ptr)
+            xRelocLog->pop_back();
+    }
 }
 
 // Retrieves the current emitter buffer target address.
@@ -763,6 +773,8 @@ static void EmitLeaMagic(const xRegisterInt &to, const xIndirectVoid &src, bool
 
         if (src.Index.IsEmpty()) {
             xMOV(to, src.Displacement);
+            if (src.Displacement)
+                xRecordReloc(xReloc_Abs32, 4);
             return;
         }
         else if (displacement_size == 0) {
@@ -0,0 +1,518 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2020  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Headless benchmark runner for the libretro core.
+//
+// Acts as a minimal libretro frontend: loads the content, runs a fixed number of frames
+// as fast as possible with the Null or Software renderer (no GPU, no display), and prints
+// frame timings, per-thread CPU time and the core's perf counters as JSON on stdout.
+//
+//   pcsx2_bench [--frames N] [--warmup N] [--renderer Null|Software] [--system DIR]
+//               [--save DIR] [--set key=value]... [--verbose] <iso|elf>
+//
+// The BIOS is looked up the same way as with any frontend: <system>/pcsx2/bios.
+
+#include <libretro.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+typedef std::chrono::steady_clock Clock;
+
+static std::map<std::string, std::string> s_variables;
+static std::map<std::string, std::string> s_overrides;
+static std::string s_system_dir = ".";
+static std::string s_save_dir;
+static bool s_verbose = false;
+
+static retro_hw_render_callback s_hw_render = {};
+static bool s_hw_render_set = false;
+
+static std::vector<retro_perf_counter*> s_perf_counters;
+static unsigned s_video_frames = 0;
+static unsigned s_audio_frames = 0;
+
+// --------------------------------------------------------------------------------------
+//  Frontend callbacks
+// --------------------------------------------------------------------------------------
+static void RETRO_CALLCONV log_printf(enum retro_log_level level, const char* fmt, ...)
+{
+	if (level < RETRO_LOG_WARN && !s_verbose)
+		return;
+
+	va_list args;
+	va_start(args, fmt);
+	vfprintf(stderr, fmt, args);
+	va_end(args);
+}
+
+static retro_time_t RETRO_CALLCONV perf_get_time_usec(void)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// TSC ticks, like the core's own subsystem counters (and RetroArch on x86), so that every
+// perf counter is in the same unit.  They are converted to ns with the measured TSC rate.
+static retro_perf_tick_t RETRO_CALLCONV perf_get_counter(void)
+{
+	return __rdtsc();
+}
+
+static uint64_t RETRO_CALLCONV perf_get_cpu_features(void)
+{
+	return 0;
+}
+
+static void RETRO_CALLCONV perf_log(void)
+{
+}
+
+static void RETRO_CALLCONV perf_register(struct retro_perf_counter* counter)
+{
+	counter->registered = true;
+	s_perf_counters.push_back(counter);
+}
+
+static void RETRO_CALLCONV perf_start(struct retro_perf_counter* counter)
+{
+	if (counter->registered)
+		counter->start = perf_get_counter();
+}
+
+static void RETRO_CALLCONV perf_stop(struct retro_perf_counter* counter)
+{
+	counter->total += perf_get_counter() - counter->start;
+	counter->call_cnt++;
+}
+
+static bool RETRO_CALLCONV set_rumble_state(unsigned port, enum retro_rumble_effect effect, uint16_t strength)
+{
+	return true;
+}
+
+// "Description; default|value|value..."
+static void set_variables(const retro_variable* vars)
+{
+	for (; vars->key; vars++)
+	{
+		if (!vars->value)
+			continue;
+
+		const char* def = strstr(vars->value, "; ");
+		if (!def)
+			continue;
+
+		def += 2;
+		const char* end = strchr(def, '|');
+		s_variables[vars->key] = end ? std::string(def, end) : std::string(def);
+	}
+}
+
+static bool RETRO_CALLCONV environment(unsigned cmd, void* data)
+{
+	switch (cmd)
+	{
+		case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+			((retro_log_callback*)data)->log = log_printf;
+			return true;
+
+		case RETRO_ENVIRONMENT_GET_PERF_INTERFACE:
+		{
+			retro_perf_callback* perf = (retro_perf_callback*)data;
+			perf->get_time_usec = perf_get_time_usec;
+			perf->get_cpu_features = perf_get_cpu_features;
+			perf->get_perf_counter = perf_get_counter;
+			perf->perf_register = perf_register;
+			perf->perf_start = perf_start;
+			perf->perf_stop = perf_stop;
+			perf->perf_log = perf_log;
+			return true;
+		}
+
+		case RETRO_ENVIRONMENT_GET_RUMBLE_INTERFACE:
+			((retro_rumble_interface*)data)->set_rumble_state = set_rumble_state;
+			return true;
+
+		case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+			*(const char**)data = s_system_dir.c_str();
+			return true;
+
+		case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+			*(const char**)data = s_save_dir.c_str();
+			return true;
+
+		case RETRO_ENVIRONMENT_SET_VARIABLES:
+			set_variables((const retro_variable*)data);
+			return true;
+
+		case RETRO_ENVIRONMENT_GET_VARIABLE:
+		{
+			retro_variable* var = (retro_variable*)data;
+			auto it = s_overrides.find(var->key);
+			if (it == s_overrides.end())
+				it = s_variables.find(var->key);
+			if (it == s_variables.end())
+				return false;
+			var->value = it->second.c_str();
+			return true;
+		}
+
+		case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+			*(bool*)data = false;
+			return true;
+
+		case RETRO_ENVIRONMENT_SET_HW_RENDER:
+		{
+			// Only the context-less path works here: the core still expects a
+			// context_reset call before it opens the GS.
+			retro_hw_render_callback* hw = (retro_hw_render_callback*)data;
+			if (hw->context_type != RETRO_HW_CONTEXT_NONE)
+				return false;
+			s_hw_render = *hw;
+			s_hw_render_set = true;
+			return true;
+		}
+
+		case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+		case RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME:
+		case RETRO_ENVIRONMENT_SET_MEMORY_MAPS:
+		case RETRO_ENVIRONMENT_SET_CONTROLLER_INFO:
+		case RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS:
+		case RETRO_ENVIRONMENT_SET_DISK_CONTROL_EXT_INTERFACE:
+		case RETRO_ENVIRONMENT_SET_MESSAGE:
+			return true;
+
+		default:
+			return false;
+	}
+}
+
+static void RETRO_CALLCONV video_refresh(const void* data, unsigned width, unsigned height, size_t pitch)
+{
+	if (data)
+		s_video_frames++;
+}
+
+static void RETRO_CALLCONV audio_sample(int16_t left, int16_t right)
+{
+	s_audio_frames++;
+}
+
+static size_t RETRO_CALLCONV audio_sample_batch(const int16_t* data, size_t frames)
+{
+	s_audio_frames += frames;
+	return frames;
+}
+
+static void RETRO_CALLCONV input_poll(void)
+{
+}
+
+static int16_t RETRO_CALLCONV input_state(unsigned port, unsigned device, unsigned index, unsigned id)
+{
+	return 0;
+}
+
+// --------------------------------------------------------------------------------------
+//  Thread CPU time
+// --------------------------------------------------------------------------------------
+// The EE and IOP share the "EE Core" thread, VU1 gets its own thread when MTVU is on, and
+// the GS runs on the frontend thread (retro_run), so per-thread CPU time is per-subsystem
+// CPU time.  Anything else (SW rasterizer workers, ...) is reported as "other".
+
+struct ThreadTimes
+{
+	double ee_iop = 0, vu1 = 0, gs = 0, other = 0;
+};
+
+static double read_thread_seconds(const std::string& task)
+{
+	// schedstat is in nanoseconds; stat only has clock ticks.
+	if (FILE* fp = fopen((task + "/schedstat").c_str(), "r"))
+	{
+		unsigned long long ns = 0;
+		int n = fscanf(fp, "%llu", &ns);
+		fclose(fp);
+		if (n == 1)
+			return ns / 1e9;
+	}
+
+	double seconds = 0;
+	if (FILE* fp = fopen((task + "/stat").c_str(), "r"))
+	{
+		char buf[1024];
+		size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+		buf[len] = 0;
+		fclose(fp);
+
+		// fields after the comm: state(3) ... utime(14) stime(15)
+		unsigned long utime = 0, stime = 0;
+		if (const char* p = strrchr(buf, ')'))
+			if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) == 2)
+				seconds = (double)(utime + stime) / sysconf(_SC_CLK_TCK);
+	}
+	return seconds;
+}
+
+static ThreadTimes read_thread_times()
+{
+	ThreadTimes t;
+	const std::string self = std::to_string(getpid());
+
+	DIR* dir = opendir("/proc/self/task");
+	if (!dir)
+		return t;
+
+	while (dirent* ent = readdir(dir))
+	{
+		if (ent->d_name[0] == '.')
+			continue;
+
+		const std::string task = std::string("/proc/self/task/") + ent->d_name;
+		const double seconds = read_thread_seconds(task);
+
+		char comm[64] = {};
+		if (FILE* fp = fopen((task + "/comm").c_str(), "r"))
+		{
+			if (fgets(comm, sizeof(comm), fp))
+				comm[strcspn(comm, "\n")] = 0;
+			fclose(fp);
+		}
+
+		if (self == ent->d_name)
+			t.gs += seconds;
+		else if (!strcmp(comm, "EE Core"))
+			t.ee_iop += seconds;
+		else if (!strcmp(comm, "MTVU"))
+			t.vu1 += seconds;
+		else
+			t.other += seconds;
+	}
+
+	closedir(dir);
+	return t;
+}
+
+// --------------------------------------------------------------------------------------
+//  main
+// --------------------------------------------------------------------------------------
+static void usage(const char* argv0)
+{
+	fprintf(stderr,
+		"usage: %s [--frames N] [--warmup N] [--renderer Null|Software] [--system DIR]\n"
+		"          [--save DIR] [--set key=value]... [--verbose] <iso|elf>\n", argv0);
+}
+
+static std::string json_escape(const std::string& s)
+{
+	std::string out;
+	for (unsigned char c : s)
+	{
+		if (c == '"' || c == '\\')
+		{
+			out += '\\';
+			out += c;
+		}
+		else if (c < 0x20)
+		{
+			char buf[8];
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			out += buf;
+		}
+		else
+			out += c;
+	}
+	return out;
+}
+
+static double percentile(std::vector<double> v, double p)
+{
+	if (v.empty())
+		return 0;
+	std::sort(v.begin(), v.end());
+	return v[std::min<size_t>(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+int main(int argc, char** argv)
+{
+	unsigned frames = 600;
+	unsigned warmup = 0;
+	std::string renderer = "Null";
+	std::string content;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const bool has_value = i + 1 < argc;
+
+		if (!strcmp(arg, "--frames") && has_value)
+			frames = atoi(argv[++i]);
+		else if (!strcmp(arg, "--warmup") && has_value)
+			warmup = atoi(argv[++i]);
+		else if (!strcmp(arg, "--renderer") && has_value)
+			renderer = argv[++i];
+		else if (!strcmp(arg, "--system") && has_value)
+			s_system_dir = argv[++i];
+		else if (!strcmp(arg, "--save") && has_value)
+			s_save_dir = argv[++i];
+		else if (!strcmp(arg, "--set") && has_value)
+		{
+			const std::string kv = argv[++i];
+			const size_t eq = kv.find('=');
+			if (eq == std::string::npos)
+			{
+				usage(argv[0]);
+				return 1;
+			}
+			s_overrides[kv.substr(0, eq)] = kv.substr(eq + 1);
+		}
+		else if (!strcmp(arg, "--verbose"))
+			s_verbose = true;
+		else if (arg[0] != '-' && content.empty())
+			content = arg;
+		else
+		{
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (content.empty() || !frames)
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (s_save_dir.empty())
+		s_save_dir = s_system_dir;
+
+	s_overrides["pcsx2_renderer"] = renderer;
+
+	retro_set_environment(environment);
+	retro_set_video_refresh(video_refresh);
+	retro_set_audio_sample(audio_sample);
+	retro_set_audio_sample_batch(audio_sample_batch);
+	retro_set_input_poll(input_poll);
+	retro_set_input_state(input_state);
+
+	retro_init();
+
+	retro_game_info game = {};
+	game.path = content.c_str();
+
+	if (!retro_load_game(&game))
+	{
+		fprintf(stderr, "Failed to load %s\n", content.c_str());
+		retro_deinit();
+		return 1;
+	}
+
+	// What a frontend does once the (here non-existent) video context is up.
+	if (s_hw_render_set && s_hw_render.context_reset)
+		s_hw_render.context_reset();
+
+	retro_system_av_info av = {};
+	retro_get_system_av_info(&av);
+
+	for (unsigned i = 0; i < warmup; i++)
+		retro_run();
+
+	s_video_frames = 0;
+	s_audio_frames = 0;
+	for (retro_perf_counter* counter : s_perf_counters)
+	{
+		counter->total = 0;
+		counter->call_cnt = 0;
+	}
+
+	std::vector<double> frame_ms;
+	frame_ms.reserve(frames);
+
+	const ThreadTimes before = read_thread_times();
+	const Clock::time_point start = Clock::now();
+	const retro_perf_tick_t start_ticks = perf_get_counter();
+
+	for (unsigned i = 0; i < frames; i++)
+	{
+		const Clock::time_point t0 = Clock::now();
+		retro_run();
+		frame_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+	}
+
+	const retro_perf_tick_t end_ticks = perf_get_counter();
+	const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+	const double tsc_hz = wall > 0 ? (end_ticks - start_ticks) / wall : 0.0;
+	const ThreadTimes after = read_thread_times();
+
+	double sum = 0;
+	for (double ms : frame_ms)
+		sum += ms;
+
+	printf("{\n");
+	printf("  \"content\": \"%s\",\n", json_escape(content).c_str());
+	printf("  \"renderer\": \"%s\",\n", json_escape(renderer).c_str());
+	printf("  \"frames\": %u,\n", frames);
+	printf("  \"warmup_frames\": %u,\n", warmup);
+	printf("  \"video_frames\": %u,\n", s_video_frames);
+	printf("  \"audio_frames\": %u,\n", s_audio_frames);
+	printf("  \"wall_time_s\": %.6f,\n", wall);
+	printf("  \"fps\": %.3f,\n", frames / wall);
+	printf("  \"speed\": %.4f,\n", av.timing.fps > 0 ? frames / wall / av.timing.fps : 0.0);
+	printf("  \"frame_time_ms\": {\"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+		sum / frames,
+		*std::min_element(frame_ms.begin(), frame_ms.end()),
+		percentile(frame_ms, 0.50),
+		percentile(frame_ms, 0.99),
+		*std::max_element(frame_ms.begin(), frame_ms.end()));
+	printf("  \"thread_cpu_s\": {\"ee_iop\": %.6f, \"vu1\": %.6f, \"gs\": %.6f, \"other\": %.6f},\n",
+		after.ee_iop - before.ee_iop,
+		after.vu1 - before.vu1,
+		after.gs - before.gs,
+		after.other - before.other);
+	printf("  \"tsc_hz\": %.0f,\n", tsc_hz);
+	printf("  \"perf_counters\": {");
+	for (size_t i = 0; i < s_perf_counters.size(); i++)
+	{
+		const retro_perf_counter* counter = s_perf_counters[i];
+		printf("%s\n    \"%s\": {\"calls\": %llu, \"total_ticks\": %llu, \"total_ns\": %.0f}", i ? "," : "",
+			json_escape(counter->ident).c_str(), (unsigned long long)counter->call_cnt, (unsigned long long)counter->total,
+			tsc_hz > 0 ? counter->total * 1e9 / tsc_hz : 0.0);
+	}
+	printf("%s}\n", s_perf_counters.empty() ? "" : "\n  ");
+	printf("}\n");
+	fflush(stdout);
+
+	retro_unload_game();
+	retro_deinit();
+
+	return 0;
+}
@@ -8,4 +8,6 @@ void Update();
 void Shutdown();
 void RumbleEnabled(bool enabled, int percent);
 void setRumbleLevel(int percent);
+void SetRewindButton(int combo);
+bool RewindHeld();
 }
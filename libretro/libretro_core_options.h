@@ -88,6 +88,7 @@ struct retro_core_option_definition option_defs[] = {
 		{"D3D11", NULL},
 #endif
 		{"OpenGl", NULL},
+		{"Software", NULL},
 		{NULL, NULL},
 	},
 	"Auto"},
@@ -481,6 +482,117 @@ struct retro_core_option_definition option_defs[] = {
 	},
 	"2" },
 
+	{BOOL_PCSX2_OPT_DETERMINISTIC,
+	"Emulation: Deterministic Mode",
+	"Runs the EE, GS and VU1 threads in lockstep with the frontend, one frame at a time, so the same inputs always produce the same results. Meant for benchmarking, netplay and run-ahead. Slightly slower. (Content restart required)",
+	{
+		{"disabled", NULL},
+		{"enabled", NULL},
+		{NULL, NULL},
+	},
+	"disabled" },
+
+	{BOOL_PCSX2_OPT_EE_BLOCK_PROFILER,
+	"Emulation: EE Block Profiler",
+	"Counts how often each recompiled EE block runs and samples its cost. The hottest blocks are written to the log when the core shuts down. For developers, slows down emulation. (Content restart required)",
+	{
+		{"disabled", NULL},
+		{"enabled", NULL},
+		{NULL, NULL},
+	},
+	"disabled" },
+
+	{BOOL_PCSX2_OPT_EE_SUPERBLOCKS,
+	"Emulation: EE Superblocks",
+	"Recompiles frequently run EE code as longer blocks that follow jumps and forward branches, keeping registers in host registers across them. Can improve speed in CPU-heavy games. Experimental. (Content restart required)",
+	{
+		{"disabled", NULL},
+		{"enabled", NULL},
+		{NULL, NULL},
+	},
+	"disabled" },
+
+	{BOOL_PCSX2_OPT_EE_FASTMEM,
+	"Emulation: EE Fastmem",
+	"Maps the PS2 main RAM into host memory at its PS2 addresses, so recompiled EE loads and stores become a single host memory access. Accesses to hardware registers are detected on their first use and switched back to the normal path. Linux only, ignored elsewhere. Experimental. (Content restart required)",
+	{
+		{"disabled", NULL},
+		{"enabled", NULL},
+		{NULL, NULL},
+	},
+	"disabled" },
+
+	{BOOL_PCSX2_OPT_REC_BLOCK_CACHE,
+	"Emulation: Recompiler Block Cache",
+	"Keeps the recompiled EE and IOP code of each game, and which VU microprograms it ran, in a file per game in the save folder. On the next boot that code is copied back instead of recompiled when the game reaches it, and the microprograms are recompiled in the background while the VUs are idle, which reduces stutter in the first minutes of play. Code that changed since is recompiled as usual. Only supported on Linux and Windows. (Content restart required)",
+	{
+		{"disabled", NULL},
+		{"enabled", NULL},
+		{NULL, NULL},
+	},
+	"disabled" },
+
+	{BOOL_PCSX2_OPT_VU_COMPILE_AHEAD,
+	"Emulation: VU1 Compile Ahead",
+	"With MTVU enabled, recompiles newly uploaded VU1 microprograms while the VU1 thread has nothing else to do, instead of when the game first runs them. Reduces the stalls new microprograms cause on the VU1 thread.",
+	{
+		{"disabled", NULL},
+		{"enabled", NULL},
+		{NULL, NULL},
+	},
+	"disabled" },
+
+	{INT_PCSX2_OPT_MTVU_RING_SIZE,
+	"Emulation: MTVU Ring Size",
+	"Size of the queue between the EE and the VU1 thread when MTVU is enabled. Larger queues let the EE run further ahead of VU1 before it has to wait. The VU1 thread statistics written to the log when a game ends help tuning it. (Content restart required)",
+	{
+		{"4", "4 MB"},
+		{"8", "8 MB"},
+		{"16", "16 MB (default)"},
+		{"32", "32 MB"},
+		{"64", "64 MB"},
+		{NULL, NULL},
+	},
+	"16" },
+
+	{INT_PCSX2_OPT_REWIND_BUFFER,
+	"Emulation: Rewind Buffer Size",
+	"Memory reserved for rewinding, in MB. The most recent state is kept in full and counts towards it; only the changes between snapshots are kept, so this usually covers a lot more frames than it suggests. See 'Rewind Button' for how to rewind.",
+	{
+		{"0", "disabled"},
+		{"64", "64 MB"},
+		{"128", "128 MB"},
+		{"256", "256 MB"},
+		{"512", "512 MB"},
+		{"1024", "1024 MB"},
+		{NULL, NULL},
+	},
+	"0" },
+
+	{INT_PCSX2_OPT_REWIND_GRANULARITY,
+	"Emulation: Rewind Granularity",
+	"Number of frames between rewind snapshots. Higher values cost less per frame and cover a longer time span.",
+	{
+		{"1", "1 (default)"},
+		{"2", "2"},
+		{"4", "4"},
+		{"8", "8"},
+		{NULL, NULL},
+	},
+	"1" },
+
+	{INT_PCSX2_OPT_REWIND_BUTTON,
+	"Emulation: Rewind Button",
+	"What to hold to rewind. The buttons are those of the first controller and show up in its controls menu.",
+	{
+		{"0", "Keyboard Backspace"},
+		{"1", "L3 + R3 (default)"},
+		{"2", "Select + L3"},
+		{"3", "Select + R3"},
+		{NULL, NULL},
+	},
+	"1" },
+
 	{INT_PCSX2_OPT_EE_CLAMPING_MODE,
 	"Emulation: EE/FPU Clamping Mode",
 	"EE/FPU clamping mode can fix some bugs on some games. Default value is fine for most games. (Content restart required)",
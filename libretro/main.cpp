@@ -28,14 +28,19 @@
 #include "SPU2/Global.h"
 #include "ps2/BiosTools.h"
 #include "memcard_retro.h"
+#include "SaveState.h"
+#include "Rewind.h"
+#include "Patch.h"
+#include "Gif_Unit.h"
+#include "Utilities/SubsystemTiming.h"
 
 
 
 #include "MTVU.h"
 
-#ifdef PERF_TEST
 static struct retro_perf_callback perf_cb;
 
+#ifdef PERF_TEST
 #define RETRO_PERFORMANCE_INIT(name)                 \
 	retro_perf_tick_t current_ticks;                 \
 	static struct retro_perf_counter name = {#name}; \
@@ -88,6 +93,10 @@ wxFileName legacy_memcard2;
 
 wxFileName save_game_folder;
 
+static size_t serialize_size = 0;
+static int rewind_granularity = 1;
+static int rewind_frame_count = 0;
+
 static std::vector<std::string> bios_files;
 static std::vector<std::string> custom_memcard_list_slot1;
 static std::vector<std::string> custom_memcard_list_slot2;
@@ -102,9 +111,46 @@ void retro_set_environment(retro_environment_t cb)
 	environ_cb = cb;
 	bool no_game = true;
 	environ_cb(RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME, &no_game);
-#ifdef PERF_TEST
-	environ_cb(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &perf_cb);
-#endif
+	if (!environ_cb(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &perf_cb))
+		memset(&perf_cb, 0, sizeof(perf_cb));
+}
+
+// Per-subsystem thread time (see SubsystemTiming.h), exported as one frontend perf counter
+// each.  The counters are not started/stopped by the frontend: retro_run adds the ticks
+// and calls accumulated since the previous frame.
+static struct retro_perf_counter subsystem_perf[SubsystemTiming::CounterCount];
+static char subsystem_perf_ident[SubsystemTiming::CounterCount][32];
+static u64 subsystem_ticks[SubsystemTiming::CounterCount];
+static u64 subsystem_calls[SubsystemTiming::CounterCount];
+
+static void subsystem_perf_update()
+{
+	if (!perf_cb.perf_register)
+		return;
+
+	u64 ticks[SubsystemTiming::CounterCount];
+	u64 calls[SubsystemTiming::CounterCount];
+	SubsystemTiming::Snapshot(ticks, calls);
+
+	for (int i = SubsystemTiming::None + 1; i < SubsystemTiming::CounterCount; i++)
+	{
+		retro_perf_counter& counter = subsystem_perf[i];
+		if (!counter.ident)
+		{
+			snprintf(subsystem_perf_ident[i], sizeof(subsystem_perf_ident[i]), "pcsx2_%s", SubsystemTiming::g_names[i]);
+			counter.ident = subsystem_perf_ident[i];
+		}
+		if (!counter.registered)
+			perf_cb.perf_register(&counter);
+		else
+		{
+			counter.total += ticks[i] - subsystem_ticks[i];
+			counter.call_cnt += calls[i] - subsystem_calls[i];
+		}
+	}
+
+	memcpy(subsystem_ticks, ticks, sizeof(ticks));
+	memcpy(subsystem_calls, calls, sizeof(calls));
 }
 
 void retro_init(void)
@@ -379,7 +425,16 @@ void retro_init(void)
 		g_Conf->EmuOptions.GS.FramesToDraw = option_value(INT_PCSX2_OPT_FRAMES_TO_DRAW, KeyOptionInt::return_type);
 		g_Conf->EmuOptions.GS.FramesToSkip = option_value(INT_PCSX2_OPT_FRAMES_TO_SKIP, KeyOptionInt::return_type);
 		g_Conf->EmuOptions.GS.VsyncQueueSize = option_value(INT_PCSX2_OPT_VSYNC_MTGS_QUEUE, KeyOptionInt::return_type);
+		g_Conf->EmuOptions.Speedhacks.vuThreadRingSize = option_value(INT_PCSX2_OPT_MTVU_RING_SIZE, KeyOptionInt::return_type);
 		g_Conf->EmuOptions.EnableCheats = option_value(BOOL_PCSX2_OPT_ENABLE_CHEATS, KeyOptionBool::return_type);
+		g_Conf->EmuOptions.DeterministicSync = option_value(BOOL_PCSX2_OPT_DETERMINISTIC, KeyOptionBool::return_type);
+		g_Conf->EmuOptions.EEBlockProfiler = option_value(BOOL_PCSX2_OPT_EE_BLOCK_PROFILER, KeyOptionBool::return_type);
+		g_Conf->EmuOptions.EESuperblocks = option_value(BOOL_PCSX2_OPT_EE_SUPERBLOCKS, KeyOptionBool::return_type);
+		g_Conf->EmuOptions.EEFastmem = option_value(BOOL_PCSX2_OPT_EE_FASTMEM, KeyOptionBool::return_type);
+		g_Conf->EmuOptions.RecBlockCache = option_value(BOOL_PCSX2_OPT_REC_BLOCK_CACHE, KeyOptionBool::return_type);
+		g_Conf->EmuOptions.RecCacheFolder = wxFileName(save_dir_root.GetPath(), "");
+		g_Conf->EmuOptions.RecCacheFolder.AppendDir("cache");
+		g_Conf->EmuOptions.VUCompileAhead = option_value(BOOL_PCSX2_OPT_VU_COMPILE_AHEAD, KeyOptionBool::return_type);
 
 
 		int EE_clampMode = option_value(INT_PCSX2_OPT_EE_CLAMPING_MODE, KeyOptionInt::return_type);
@@ -400,6 +455,8 @@ void retro_init(void)
 
 		option_pad_left_deadzone = option_value(INT_PCSX2_OPT_GAMEPAD_L_DEADZONE, KeyOptionInt::return_type);
 		option_pad_right_deadzone = option_value(INT_PCSX2_OPT_GAMEPAD_R_DEADZONE, KeyOptionInt::return_type);
+		g_RewindBuffer.SetBudget((size_t)option_value(INT_PCSX2_OPT_REWIND_BUFFER, KeyOptionInt::return_type) * _1mb);
+		rewind_granularity = option_value(INT_PCSX2_OPT_REWIND_GRANULARITY, KeyOptionInt::return_type);
 
 		static retro_disk_control_ext_callback disk_control = {
 			DiskControl::set_eject_state,
@@ -476,6 +533,14 @@ void retro_get_system_av_info(retro_system_av_info* info)
 	info->geometry.max_width = info->geometry.base_width;
 	info->geometry.max_height = info->geometry.base_height;
 
+	// The software renderer outputs the PCRTC frame at whatever size the game set up
+	// (512x448, 640x512, interlaced 640x896, ...).
+	if (!std::strcmp(option_value(STRING_PCSX2_OPT_RENDERER, KeyOptionString::return_type), "Software"))
+	{
+		info->geometry.max_width = 1024;
+		info->geometry.max_height = 1024;
+	}
+
 	if (option_value(INT_PCSX2_OPT_ASPECT_RATIO, KeyOptionInt::return_type) == 0)
 		info->geometry.aspect_ratio = 4.0f / 3.0f;
 	else
@@ -488,7 +553,9 @@ void retro_reset(void)
 {
 	GetMTGS().FinishTaskInThread();
 	GetCoreThread().ResetQuick();
+	GetMTGS().LockstepRestart();
 	DiskControl::eject_state = false;
+	g_RewindBuffer.Reset();
 }
 
 static void context_reset(void)
@@ -608,6 +675,26 @@ read_m3u_file(const wxFileName& m3u_file)
 	return result;
 }
 
+// Hands the frontend direct pointers into guest memory (achievements, cheat search, ...).
+// All of these stay at the same host address for the lifetime of the core.
+static void set_memory_maps(void)
+{
+	static struct retro_memory_descriptor descs[] = {
+		{RETRO_MEMDESC_SYSTEM_RAM, NULL, 0, 0x00000000, 0, 0, Ps2MemSize::MainRam, "EE"},
+		{0, NULL, 0, 0x70000000, 0, 0, Ps2MemSize::Scratch, "EE"},
+		{0, NULL, 0, 0x1C000000, 0, 0, Ps2MemSize::IopRam, "EE"},
+		{0, NULL, 0, 0x00000000, 0, 0, 0x200000, "SPU2"},
+	};
+
+	descs[0].ptr = eeMem->Main;
+	descs[1].ptr = eeMem->Scratch;
+	descs[2].ptr = iopMem->Main;
+	descs[3].ptr = _spu2mem;
+
+	struct retro_memory_map mmaps = {descs, sizeof(descs) / sizeof(*descs)};
+	environ_cb(RETRO_ENVIRONMENT_SET_MEMORY_MAPS, &mmaps);
+}
+
 bool retro_load_game(const struct retro_game_info* game)
 {
 	if (init_failed)
@@ -617,6 +704,8 @@ bool retro_load_game(const struct retro_game_info* game)
 	}
 
 	ResetContentStuffs();
+	serialize_size = 0;
+	g_RewindBuffer.Reset();
 
 	const char* selected_bios = sel_bios_path.c_str();
 	if (selected_bios == NULL)
@@ -728,6 +817,10 @@ bool retro_load_game(const struct retro_game_info* game)
 	}
 
 
+	// Commit guest memory here rather than on the core thread's first run, so the memory
+	// maps point at live memory as soon as the game is loaded.
+	GetVmMemory().CommitAll();
+
 	if (game)
 	{
 
@@ -809,6 +902,7 @@ bool retro_load_game(const struct retro_game_info* game)
 	}
 
 	g_Conf->EmuOptions.GS.FramesToDraw = 1;
+	set_memory_maps();
 	//	g_Conf->CurrentGameArgs = "";
 
 	Input::Init();
@@ -816,6 +910,7 @@ bool retro_load_game(const struct retro_game_info* game)
 			option_value(BOOL_PCSX2_OPT_GAMEPAD_RUMBLE_ENABLE, KeyOptionBool::return_type),
 			option_value(INT_PCSX2_OPT_GAMEPAD_RUMBLE_FORCE, KeyOptionInt::return_type)
 			);
+	Input::SetRewindButton(option_value(INT_PCSX2_OPT_REWIND_BUTTON, KeyOptionInt::return_type));
 
 	retro_hw_context_type context_type = RETRO_HW_CONTEXT_OPENGL;
 	const char* option_renderer = option_value(STRING_PCSX2_OPT_RENDERER, KeyOptionString::return_type);
@@ -829,6 +924,21 @@ bool retro_load_game(const struct retro_game_info* game)
 #endif
 	else if (!std::strcmp(option_renderer, "Null"))
 		context_type = RETRO_HW_CONTEXT_NONE;
+	else if (!std::strcmp(option_renderer, "Software"))
+	{
+		// The software renderer presents 32-bit frames from system memory, so there's no hw
+		// context to wait for: open the GS right away.  Frontends only have to honour the pixel
+		// format when it is set from here, not from retro_init.
+		enum retro_pixel_format xrgb888 = RETRO_PIXEL_FORMAT_XRGB8888;
+		if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &xrgb888))
+		{
+			log_cb(RETRO_LOG_ERROR, "The frontend doesn't support XRGB8888 output, which the Software renderer needs\n");
+			return false;
+		}
+		hw_render.context_type = RETRO_HW_CONTEXT_NONE;
+		context_reset();
+		return true;
+	}
 
 	return set_hw_render(context_type);
 }
@@ -844,6 +954,7 @@ void retro_unload_game(void)
 	//	GetMTGS().FinishTaskInThread();
 	//		GetMTGS().CloseGS();
 	GetMTGS().FinishTaskInThread();
+	GetMTGS().LogWakeLatency();
 
 	while (pcsx2->HasPendingEvents())
 		pcsx2->ProcessPendingEvents();
@@ -854,6 +965,44 @@ void retro_unload_game(void)
 }
 
 
+// Savestates are taken straight into / out of the frontend's buffer (no temp files, no
+// zip step).  The EE is paused at its next vsync and everything it queued for the GS is
+// flushed first, so the GS and GIF path state frozen here is consistent with the EE's.
+
+static void serialize_begin(void)
+{
+	GetMTGS().FinishTaskInThread();
+	GetCoreThread().Pause();
+	GetMTGS().FlushRingInThread();
+}
+
+static void serialize_end(void)
+{
+	GetCoreThread().Resume();
+}
+
+// Pauses the core thread for a savestate operation and resumes it however the operation ends
+class ScopedSerialize
+{
+public:
+	ScopedSerialize() { serialize_begin(); }
+	~ScopedSerialize() { serialize_end(); }
+};
+
+// Prefixed to the states handed to the frontend, so that foreign or truncated buffers are
+// rejected before anything is loaded from them.
+struct RetroStateHeader
+{
+	u32 magic;
+	u32 version;  // g_SaveVersion
+	u32 size;     // of the state that follows
+	u32 reserved;
+};
+static const u32 RetroStateMagic = 0x53325350; // "PS2S"
+
+// Frontends ask for the state size once, but the GIF path buffers can still grow afterwards
+static const size_t RetroStatePadding = _1mb;
+
 void retro_run(void)
 {
 	bool updated = false;
@@ -869,33 +1018,158 @@ void retro_run(void)
 			option_value(BOOL_PCSX2_OPT_GAMEPAD_RUMBLE_ENABLE, KeyOptionBool::return_type),
 			option_value(INT_PCSX2_OPT_GAMEPAD_RUMBLE_FORCE, KeyOptionInt::return_type)
 		);
+		Input::SetRewindButton(option_value(INT_PCSX2_OPT_REWIND_BUTTON, KeyOptionInt::return_type));
 		option_pad_left_deadzone = option_value(INT_PCSX2_OPT_GAMEPAD_L_DEADZONE, KeyOptionInt::return_type);
 		option_pad_right_deadzone = option_value(INT_PCSX2_OPT_GAMEPAD_R_DEADZONE, KeyOptionInt::return_type);
+		g_RewindBuffer.SetBudget((size_t)option_value(INT_PCSX2_OPT_REWIND_BUFFER, KeyOptionInt::return_type) * _1mb);
+		rewind_granularity = option_value(INT_PCSX2_OPT_REWIND_GRANULARITY, KeyOptionInt::return_type);
 
 	}
 
 	Input::Update();
 
+	// The EE parks after each vsync in deterministic mode; let it run the frame for this input.
+	if (EmuConfig.DeterministicSync)
+		GetMTGS().LockstepRelease();
+
 	RETRO_PERFORMANCE_INIT(pcsx2_run);
 	RETRO_PERFORMANCE_START(pcsx2_run);
 
 	GetMTGS().ExecuteTaskInThread();
 
 	RETRO_PERFORMANCE_STOP(pcsx2_run);
+
+	subsystem_perf_update();
+
+	SndBuffer::Flush();
+
+	if (g_RewindBuffer.IsEnabled())
+	{
+		if (Input::RewindHeld())
+		{
+			serialize_begin();
+			g_RewindBuffer.Rewind();
+			serialize_end();
+			rewind_frame_count = 0;
+		}
+		else if (++rewind_frame_count >= rewind_granularity)
+		{
+			// In deterministic mode the EE parks at the frame boundary anyway, so snapshots
+			// can be taken from there without a round trip through Pause/Resume.
+			if (EmuConfig.DeterministicSync && GetMTGS().LockstepParkInThread())
+				g_RewindBuffer.Capture();
+			else
+			{
+				serialize_begin();
+				g_RewindBuffer.Capture();
+				serialize_end();
+			}
+			rewind_frame_count = 0;
+		}
+	}
 }
 
 size_t retro_serialize_size(void)
 {
-	return 0;
+	if (!GetCoreThread().HasActiveMachine())
+		return 0;
+
+	if (serialize_size)
+		return serialize_size;
+
+	// Everything but the GIF path buffers has a fixed size, so measure one state and
+	// reserve room for those to fill up completely.
+	VmStateBuffer buffer(L"retro_serialize_size");
+	try
+	{
+		ScopedSerialize scoped;
+		memSavingState saveme(buffer);
+		saveme.FreezeAll();
+		serialize_size = sizeof(RetroStateHeader) + saveme.GetCurrentPos() + RetroStatePadding;
+		for (int i = 0; i < 3; i++)
+			serialize_size += gifUnit.gifPath[i].buffSize - gifUnit.gifPath[i].curSize;
+	}
+	catch (BaseException& ex)
+	{
+		log_cb(RETRO_LOG_ERROR, "Cannot measure the savestate size: %s\n", ex.FormatDiagnosticMessage().ToUTF8().data());
+		serialize_size = 0;
+	}
+	return serialize_size;
 }
 
 bool retro_serialize(void* data, size_t size)
 {
-	return false;
+	if (!GetCoreThread().HasActiveMachine() || size < sizeof(RetroStateHeader))
+		return false;
+
+	RetroStateHeader* header = (RetroStateHeader*)data;
+	VmStateBufferRef buffer((u8*)data + sizeof(RetroStateHeader), (int)(size - sizeof(RetroStateHeader)));
+
+	try
+	{
+		ScopedSerialize scoped;
+		memSavingState saveme(buffer);
+		saveme.FreezeAll();
+		header->magic = RetroStateMagic;
+		header->version = g_SaveVersion;
+		header->size = saveme.GetCurrentPos();
+		header->reserved = 0;
+	}
+	catch (Exception::OutOfMemory&)
+	{
+		log_cb(RETRO_LOG_ERROR, "Savestate buffer too small (%u bytes)\n", (unsigned)size);
+		serialize_size = 0; // measure again next time
+		return false;
+	}
+	catch (BaseException& ex)
+	{
+		log_cb(RETRO_LOG_ERROR, "Savestate failed: %s\n", ex.FormatDiagnosticMessage().ToUTF8().data());
+		return false;
+	}
+	catch (...)
+	{
+		log_cb(RETRO_LOG_ERROR, "Savestate failed\n");
+		return false;
+	}
+
+	return true;
 }
+
 bool retro_unserialize(const void* data, size_t size)
 {
-	return false;
+	if (!GetCoreThread().HasActiveMachine())
+		return false;
+
+	const RetroStateHeader* header = (const RetroStateHeader*)data;
+	if (size < sizeof(RetroStateHeader) || header->magic != RetroStateMagic
+		|| header->version != g_SaveVersion || header->size > size - sizeof(RetroStateHeader))
+	{
+		log_cb(RETRO_LOG_ERROR, "Rejecting savestate: not a state of this core version, or truncated\n");
+		return false;
+	}
+
+	VmStateBufferRef buffer((u8*)data + sizeof(RetroStateHeader), (int)header->size);
+	bool result = true;
+
+	try
+	{
+		ScopedSerialize scoped;
+		memLoadingState(buffer).FreezeAll();
+	}
+	catch (BaseException& ex)
+	{
+		log_cb(RETRO_LOG_ERROR, "Loading savestate failed: %s\n", ex.FormatDiagnosticMessage().ToUTF8().data());
+		result = false;
+	}
+	catch (...)
+	{
+		log_cb(RETRO_LOG_ERROR, "Loading savestate failed\n");
+		result = false;
+	}
+
+	g_RewindBuffer.Reset();
+
+	return result;
 }
 
 unsigned retro_get_region(void)
@@ -910,26 +1184,36 @@ unsigned retro_api_version()
 
 size_t retro_get_memory_size(unsigned id)
 {
+	if (id == RETRO_MEMORY_SYSTEM_RAM && eeMem)
+		return Ps2MemSize::MainRam;
+
 	return 0;
 }
 
 void* retro_get_memory_data(unsigned id)
 {
+	if (id == RETRO_MEMORY_SYSTEM_RAM && eeMem)
+		return eeMem->Main;
+
 	return NULL;
 }
 
 void retro_cheat_reset(void)
 {
+	ResetCompiledCheats();
 }
 
 void retro_cheat_set(unsigned index, bool enabled, const char* code)
 {
+	SetCompiledCheat(index, enabled, code);
 }
 
 retro_audio_sample_t sample_cb;
+retro_audio_sample_batch_t batch_cb;
 
 void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb)
 {
+	batch_cb = cb;
 }
 
 void retro_set_audio_sample(retro_audio_sample_t cb)
@@ -16,6 +16,12 @@
 #define BOOL_PCSX2_OPT_USERHACK_AUTO_FLUSH	 "pcsx2_userhack_auto_flush"
 #define BOOL_PCSX2_OPT_CONSERVATIVE_BUFFER	 "pcsx2_conservative_buffer"
 #define BOOL_PCSX2_OPT_ACCURATE_DATE		 "pcsx2_accurate_date"
+#define BOOL_PCSX2_OPT_DETERMINISTIC		 "pcsx2_deterministic"
+#define BOOL_PCSX2_OPT_EE_BLOCK_PROFILER	 "pcsx2_ee_block_profiler"
+#define BOOL_PCSX2_OPT_EE_SUPERBLOCKS		 "pcsx2_ee_superblocks"
+#define BOOL_PCSX2_OPT_EE_FASTMEM		 "pcsx2_ee_fastmem"
+#define BOOL_PCSX2_OPT_REC_BLOCK_CACHE		 "pcsx2_rec_block_cache"
+#define BOOL_PCSX2_OPT_VU_COMPILE_AHEAD		 "pcsx2_vu_compile_ahead"
 
 #define STRING_PCSX2_OPT_BIOS			 "pcsx2_bios"
 #define STRING_PCSX2_OPT_RENDERER                "pcsx2_renderer"
@@ -40,6 +46,10 @@
 #define INT_PCSX2_OPT_FXAA			 "pcsx2_fxaa"
 #define INT_PCSX2_OPT_TEXTURE_FILTERING		 "pcsx2_texture_filtering"
 #define INT_PCSX2_OPT_VSYNC_MTGS_QUEUE		 "pcsx2_vsync_mtgs_queue"
+#define INT_PCSX2_OPT_MTVU_RING_SIZE		 "pcsx2_mtvu_ring_size"
+#define INT_PCSX2_OPT_REWIND_BUFFER		 "pcsx2_rewind_buffer"
+#define INT_PCSX2_OPT_REWIND_GRANULARITY	 "pcsx2_rewind_granularity"
+#define INT_PCSX2_OPT_REWIND_BUTTON		 "pcsx2_rewind_button"
 #define INT_PCSX2_OPT_MIPMAPPING		 "pcsx2_mipmapping"
 #define INT_PCSX2_OPT_EE_CLAMPING_MODE		 "pcsx2_clamping_mode"
 #define INT_PCSX2_OPT_EE_ROUND_MODE		 "pcsx2_round_mode"
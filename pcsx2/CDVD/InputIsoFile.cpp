@@ -17,6 +17,7 @@
 #include "PrecompiledHeader.h"
 #include "IopCommon.h"
 #include "IsoFileFormats.h"
+#include "Utilities/SubsystemTiming.h"
 
 #include <errno.h>
 
@@ -51,6 +52,7 @@ int InputIsoFile::ReadSync(u8* dst, uint lsn)
 		return -1;
 	}
 
+	SubsystemTiming::Scope timing(SubsystemTiming::CDVDWait);
 	return m_reader->ReadSync(dst + m_blockofs, lsn, 1);
 }
 
@@ -101,7 +103,10 @@ int InputIsoFile::FinishRead3(u8* dst, uint mode)
 
 	if (m_read_inprogress)
 	{
-		ret = m_reader->FinishRead();
+		{
+			SubsystemTiming::Scope timing(SubsystemTiming::CDVDWait);
+			ret = m_reader->FinishRead();
+		}
 		m_read_inprogress = false;
 
 		if (ret < 0)
@@ -245,6 +245,7 @@ struct Pcsx2Config
 
 		s8	EECycleRate;		// EE cycle rate selector (1.0, 1.5, 2.0)
 		u8	EECycleSkip;		// EE Cycle skip factor (0, 1, 2, or 3)
+		u8	vuThreadRingSize;	// MTVU ring buffer size in MB, a power of 2 (applied when the MTVU is reset)
 
 		SpeedhackOptions();
 		SpeedhackOptions& DisableAll();
@@ -253,7 +254,7 @@ struct Pcsx2Config
 
 		bool operator ==( const SpeedhackOptions& right ) const
 		{
-			return OpEqu( bitset ) && OpEqu( EECycleRate ) && OpEqu( EECycleSkip );
+			return OpEqu( bitset ) && OpEqu( EECycleRate ) && OpEqu( EECycleSkip ) && OpEqu( vuThreadRingSize );
 		}
 
 		bool operator !=( const SpeedhackOptions& right ) const
@@ -280,7 +281,20 @@ struct Pcsx2Config
 			MultitapPort0_Enabled:1,
 			MultitapPort1_Enabled:1,
 
-			HostFs				:1;
+			HostFs				:1,
+		// runs the EE, MTGS and MTVU in lockstep so that results don't depend on thread timing
+			DeterministicSync	:1,
+		// instruments every EE recompiler block with a hit counter and sampled timing (see R5900_Profiler.h)
+			EEBlockProfiler		:1,
+		// lets the EE recompiler merge hot blocks into superblocks that run through forward branches
+			EESuperblocks		:1,
+		// maps EE RAM at its guest virtual addresses so recompiled loads/stores skip the vtlb lookup (see vtlb_Fastmem)
+			EEFastmem			:1,
+		// keeps the recompiled EE/IOP code and a list of VU programs per game on disk; the code is restored instead
+		// of recompiled, the VU programs are recompiled while the VU is idle (see RecBlockCache and microVU_Cache.inl)
+			RecBlockCache		:1,
+		// lets the MTVU thread compile newly uploaded VU1 microprograms while it is idle (see mVUcompileAhead)
+			VUCompileAhead		:1;
 	BITFIELD_END
 
 	CpuOptions			Cpu;
@@ -289,6 +303,7 @@ struct Pcsx2Config
 	GamefixOptions		Gamefixes;
 
 	wxFileName			BiosFilename;
+	wxFileName			RecCacheFolder;		// where RecBlockCache and the microVU program cache keep their files
 
 	Pcsx2Config();
 
@@ -571,6 +571,13 @@ __fi void rcntUpdate()
 {
 	rcntUpdate_vSync();
 
+#ifdef __LIBRETRO__
+	// Deterministic mode: the frame is complete once its vsync has been sent, so this is where
+	// the EE waits for the frontend to release the next frame.
+	if (EmuConfig.DeterministicSync)
+		GetMTGS().LockstepWaitInThread();
+#endif
+
 	// Update counters so that we can perform overflow and target tests.
 
 	for (int i=0; i<=3; i++)
@@ -354,6 +354,31 @@ public:
 	uint			m_packet_size;		// size of the packet (data only, ie. not including the 16 byte command!)
 	uint			m_packet_writepos;	// index of the data location in the ringbuffer.
 
+#ifdef __LIBRETRO__
+	// Set while FlushRingInThread() is running: ExecuteTaskInThread() returns as soon as
+	// the ring is empty instead of waiting for the next vsync packet.
+	bool			m_FlushingRing;
+
+	// The MTGS runs on the frontend thread and sleeps on m_sem_event until the EE kicks the
+	// ring or posts a vsync.  Pending wx events post the same semaphore (see Pcsx2App::WakeUpIdle)
+	// and set this flag, so they are handled without polling.
+	std::atomic<bool>	m_AppEventsPending;
+
+	// Post-to-consume latency of ring wakeups, in power of two microsecond buckets
+	// (bucket 0: < 1us, bucket n: < 2^n us, last bucket: everything above).
+	static const uint	WakeLatencyBuckets = 18;
+	std::atomic<s64>	m_WakePostTime;
+	u64				m_WakeLatency[WakeLatencyBuckets];
+
+	// Deterministic mode: after each vsync the EE parks until the frontend has polled the
+	// input for the next frame, so every frame runs against the same input regardless of
+	// how far ahead of the GS the EE would otherwise get.  One credit is posted per retro_run.
+	Semaphore			m_sem_Lockstep;
+	bool				m_LockstepPending;	// EE thread: a vsync was sent, park at the next counter update
+	bool				m_LockstepStarted;	// frontend thread: the boot frame has been run
+	std::atomic<bool>	m_LockstepParked;	// EE thread is waiting for its credit, the VM is idle
+#endif
+
 #ifdef RINGBUF_DEBUG_STACK
 	Threading::Mutex m_lock_Stack;
 #endif
@@ -385,6 +410,15 @@ public:
 
 	void ExecuteTaskInThread();
 	void FinishTaskInThread();
+#ifdef __LIBRETRO__
+	void FlushRingInThread();
+	void PostAppEvents();
+	void LogWakeLatency();
+	void LockstepRelease();
+	void LockstepRestart();
+	void LockstepWaitInThread();
+	bool LockstepParkInThread();
+#endif
 	void OpenGS();
 	void CloseGS();
 
@@ -398,6 +432,10 @@ protected:
 	void OnCleanupInThread();
 
 	void GenericStall( uint size );
+	void PostRingEvent();
+#ifdef __LIBRETRO__
+	void RecordWakeLatency();
+#endif
 
 	// Used internally by SendSimplePacket type functions
 	void _FinishSimplePacket();
@@ -17,12 +17,14 @@
 #include "Common.h"
 
 #include <list>
+#include <chrono>
 #include <wx/wx.h>
 
 #include "GS.h"
 #include "Gif_Unit.h"
 #include "MTVU.h"
 #include "Elfheader.h"
+#include "Utilities/SubsystemTiming.h"
 
 
 // Uncomment this to enable profiling of the GS RingBufferCopy function.
@@ -76,6 +78,16 @@ void SysMtgsThread::OnStart()
 	m_SignalRingPosition  = 0;
 
 	m_CopyDataTally		= 0;
+#ifdef __LIBRETRO__
+	m_FlushingRing		= false;
+	m_AppEventsPending	= false;
+	m_WakePostTime		= 0;
+	memzero(m_WakeLatency);
+	m_LockstepPending	= false;
+	m_LockstepStarted	= false;
+	m_LockstepParked	= false;
+	m_sem_Lockstep.Reset();
+#endif
 
 	_parent::OnStart();
 }
@@ -105,6 +117,10 @@ void SysMtgsThread::ResetGS()
 	m_ReadPos             = m_WritePos.load();
 	m_QueuedFrameCount    = 0;
 	m_VsyncSignalListener = 0;
+#ifdef __LIBRETRO__
+	m_LockstepPending     = false;
+	m_LockstepParked      = false;
+#endif
 
 	MTGS_LOG( "MTGS: Sending Reset..." );
 	SendSimplePacket( GS_RINGTYPE_RESET, 0, 0, 0 );
@@ -142,6 +158,11 @@ void SysMtgsThread::PostVsyncStart()
 	// Vsyncs should always start the GS thread, regardless of how little has actually be queued.
 	if (m_CopyDataTally != 0) SetEvent();
 
+#ifdef __LIBRETRO__
+	if (EmuConfig.DeterministicSync)
+		m_LockstepPending = true;
+#endif
+
 	// If the MTGS is allowed to queue a lot of frames in advance, it creates input lag.
 	// Use the Queued FrameCount to stall the EE if another vsync (or two) are already queued
 	// in the ringbuffer.  The queue limit is disabled when both FrameLimiting and Vsync are
@@ -163,8 +184,9 @@ void SysMtgsThread::PostVsyncStart()
 	// To avoid this potential deadlock, ring must be wake up after m_VsyncSignalListener
 	// Note: potentially we can also miss the previous wake up if we optimize away the post just before the release of busy signal of the ring
 	// So let's ensure the ring doesn't sleep
-	m_sem_event.Post();
+	PostRingEvent();
 
+	SubsystemTiming::Scope timing(SubsystemTiming::EEWait);
 	m_sem_Vsync.WaitNoCancel();
 }
 
@@ -239,6 +261,7 @@ void SysMtgsThread::ExecuteTaskInThread()
 #ifdef __LIBRETRO__
 	pxAssert(IsSelf());
 #endif
+	SubsystemTiming::Scope timing(SubsystemTiming::MTGS);
 
 	// Threading info: run in MTGS thread
 	// m_ReadPos is only update by the MTGS thread so it is safe to load it with a relaxed atomic
@@ -257,10 +280,15 @@ void SysMtgsThread::ExecuteTaskInThread()
 		busy.Release();
 #endif
 #ifdef __LIBRETRO__
-		while (wxTheApp->HasPendingEvents())
-			wxTheApp->ProcessPendingEvents();
+		// No timeout: the EE posts the event for ring data and vsyncs, and queued wx events
+		// post it through PostAppEvents(), so there is nothing to poll for.
+		{
+			SubsystemTiming::Scope idle(SubsystemTiming::None);
+			m_sem_event.WaitWithoutYield();
+		}
+		RecordWakeLatency();
 
-		while (!m_sem_event.WaitWithoutYield(wxTimeSpan::Millisecond()))
+		if (m_AppEventsPending.exchange(false))
 		{
 			while (wxTheApp->HasPendingEvents())
 				wxTheApp->ProcessPendingEvents();
@@ -484,10 +512,151 @@ void SysMtgsThread::ExecuteTaskInThread()
 		if (m_VsyncSignalListener.exchange(false))
 			m_sem_Vsync.Post();
 
+#ifdef __LIBRETRO__
+		if (m_FlushingRing)
+			return;
+#endif
+
 		//log_cb(RETRO_LOG_WARN, "(MTGS Thread) Nothing to do!  ringpos=0x%06x\n", m_ReadPos );
 	}
 }
 
+#ifdef __LIBRETRO__
+// Processes everything the EE has queued so far, including any vsyncs it got ahead by.
+// Used by savestates: the EE must be paused first, so that the ring (and the GIF path
+// read amounts) are guaranteed to be empty once this returns.
+void SysMtgsThread::FlushRingInThread()
+{
+	pxAssertDev( IsSelf(), "This method is only allowed from the MTGS thread." );
+
+	m_FlushingRing = true;
+	while( m_ReadPos.load(std::memory_order_relaxed) != m_WritePos.load(std::memory_order_acquire) )
+	{
+		m_sem_event.Post();
+		ExecuteTaskInThread();
+	}
+	m_FlushingRing = false;
+}
+
+// Called from any thread when a wx event gets queued (see Pcsx2App::WakeUpIdle).
+// The MTGS is the only loop the frontend thread spends its time in, so it handles them.
+void SysMtgsThread::PostAppEvents()
+{
+	if (!m_AppEventsPending.exchange(true))
+		m_sem_event.Post();
+}
+
+void SysMtgsThread::RecordWakeLatency()
+{
+	const s64 posted = m_WakePostTime.exchange(0, std::memory_order_relaxed);
+	if (!posted)
+		return;
+
+	const s64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	u64 us = std::max<s64>(now - posted, 0) / 1000;
+
+	uint bucket = 0;
+	while (us && bucket < WakeLatencyBuckets - 1)
+	{
+		us >>= 1;
+		bucket++;
+	}
+	m_WakeLatency[bucket]++;
+}
+
+void SysMtgsThread::LogWakeLatency()
+{
+	u64 total = 0;
+	for (uint i = 0; i < WakeLatencyBuckets; i++)
+		total += m_WakeLatency[i];
+
+	if (!total)
+		return;
+
+	log_cb(RETRO_LOG_INFO, "MTGS wake latency (%llu wakeups):\n", (unsigned long long)total);
+	for (uint i = 0; i < WakeLatencyBuckets; i++)
+	{
+		if (!m_WakeLatency[i])
+			continue;
+		if (i == WakeLatencyBuckets - 1)
+			log_cb(RETRO_LOG_INFO, "  >= %6u us: %llu\n", 1u << (i - 1), (unsigned long long)m_WakeLatency[i]);
+		else
+			log_cb(RETRO_LOG_INFO, "  <  %6u us: %llu\n", 1u << i, (unsigned long long)m_WakeLatency[i]);
+	}
+}
+
+// Called by the frontend once per retro_run, after the input has been polled.  The first
+// frame after boot or reset runs ungated, every later one hands the EE one vsync worth of credit.
+void SysMtgsThread::LockstepRelease()
+{
+	if (m_LockstepStarted)
+		m_sem_Lockstep.Post();
+	else
+		m_LockstepStarted = true;
+}
+
+void SysMtgsThread::LockstepRestart()
+{
+	m_LockstepStarted = false;
+	m_LockstepParked = false;
+	m_sem_Lockstep.Reset();
+}
+
+// EE thread: parks after a vsync has been sent until the frontend releases the next frame.
+// The wait times out regularly so that suspend/reset requests can still get the EE out of
+// here; the vsync stays pending and the EE parks again on resume.
+void SysMtgsThread::LockstepWaitInThread()
+{
+	if (!m_LockstepPending)
+		return;
+
+	// Also drain the VU1 thread, so that no microprogram straddles the frame boundary.
+	if (THREAD_VU1)
+		vu1Thread.WaitVU();
+
+	SubsystemTiming::Scope timing(SubsystemTiming::EEWait);
+	m_LockstepParked.store(true, std::memory_order_release);
+	while (!m_sem_Lockstep.WaitWithoutYield(wxTimeSpan(0, 0, 0, 1)))
+		Cpu->CheckExecutionState();
+	m_LockstepParked.store(false, std::memory_order_relaxed);
+
+	m_LockstepPending = false;
+}
+
+// Frontend thread: waits for the EE to park at the end of the frame that was just run, and
+// flushes everything it queued up to there.  Until the next LockstepRelease nothing else
+// touches the VM then, so it can be saved without pausing the core thread.  Returns false if
+// the EE doesn't get there in time (ie. it's being suspended), in which case the caller has
+// to pause it the regular way.
+bool SysMtgsThread::LockstepParkInThread()
+{
+	pxAssertDev( IsSelf(), "This method is only allowed from the MTGS thread." );
+
+	// The EE normally parks right behind the vsync it just sent: spin briefly, then back off.
+	static const int SpinCount  = 1024;
+	static const int SleepCount = 100;
+
+	for (int i = 0; i < SpinCount + SleepCount; ++i)
+	{
+		// The tail of the frame may still be in the ring, or the EE waiting on it.
+		FinishTaskInThread();
+		FlushRingInThread();
+
+		if (m_LockstepParked.load(std::memory_order_acquire))
+		{
+			FlushRingInThread();
+			return true;
+		}
+
+		if (i < SpinCount)
+			Threading::SpinWait();
+		else
+			Threading::Sleep(1);
+	}
+	return false;
+}
+#endif
+
 void SysMtgsThread::FinishTaskInThread()
 {
 	if( m_SignalRingEnable.exchange(false) )
@@ -550,6 +719,7 @@ void SysMtgsThread::WaitGS(bool syncRegs, bool weakWait, bool isMTVU)
 	// we don't want to access the content of the queue
 
 	if (isMTVU || m_ReadPos.load(std::memory_order_relaxed) != m_WritePos.load(std::memory_order_relaxed)) {
+		SubsystemTiming::Scope timing(isMTVU ? SubsystemTiming::VU1WaitGS : SubsystemTiming::EEWait);
 		SetEvent();
 		RethrowException();
 		for(;;) {
@@ -580,11 +750,23 @@ void SysMtgsThread::WaitGS(bool syncRegs, bool weakWait, bool isMTVU)
 void SysMtgsThread::SetEvent()
 {
 	if(!m_RingBufferIsBusy.load(std::memory_order_relaxed))
-		m_sem_event.Post();
+		PostRingEvent();
 
 	m_CopyDataTally = 0;
 }
 
+// Wakes the MTGS for new ring data.  The libretro build also timestamps the first post
+// of each wakeup for the latency histogram.
+void SysMtgsThread::PostRingEvent()
+{
+#ifdef __LIBRETRO__
+	s64 expected = 0;
+	const s64 now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	m_WakePostTime.compare_exchange_strong(expected, now, std::memory_order_relaxed);
+#endif
+	m_sem_event.Post();
+}
+
 u8* SysMtgsThread::GetDataPacketPtr() const
 {
 	return (u8*)&RingBuffer[m_packet_writepos & RingBufferMask];
@@ -642,6 +824,8 @@ void SysMtgsThread::GenericStall( uint size )
 
 	if (freeroom <= size)
 	{
+		SubsystemTiming::Scope timing(SubsystemTiming::EEWait);
+
 		// writepos will overlap readpos if we commit the data, so we need to wait until
 		// readpos is out past the end of the future write pos, or until it wraps around
 		// (in which case writepos will be >= readpos).
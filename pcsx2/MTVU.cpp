@@ -18,6 +18,8 @@
 #include "MTVU.h"
 #include "newVif.h"
 #include "Gif_Unit.h"
+#include "Elfheader.h"
+#include "Utilities/SubsystemTiming.h"
 
 __aligned16 VU_Thread vu1Thread(CpuVU1, VU1);
 
@@ -27,14 +29,40 @@ __aligned16 VU_Thread vu1Thread(CpuVU1, VU1);
 // Rounds up a size in bytes for size in u32's
 static __fi u32 size_u32(u32 x) { return (x + 3) >> 2; }
 
+// Both threads poll for a while before they block: the EE usually queues the next packet
+// shortly after a kick, and VU1 usually finishes shortly after the EE starts waiting on it,
+// so sleeping right away mostly pays for a wake-up.  Each side's budget adapts: it doubles
+// when the spin paid off and halves when the wait ended up blocking anyway, which keeps an
+// idle thread from burning its core.
+static const u32 spin_min = 64;   // In pause instructions
+static const u32 spin_max = 4096;
+
+template <typename Ready>
+static __fi bool SpinUntil(u32& budget, Ready ready)
+{
+	for (u32 i = 0; i < budget; i++)
+	{
+		if (ready())
+		{
+			budget = std::min(budget * 2, spin_max);
+			return true;
+		}
+		Threading::SpinWait();
+	}
+	budget = std::max(budget / 2, spin_min);
+	return false;
+}
+
 enum MTVU_EVENT
 {
 	MTVU_VU_EXECUTE,     // Execute VU program
 	MTVU_VU_WRITE_MICRO, // Write to VU micro-mem
 	MTVU_VU_WRITE_DATA,  // Write to VU data-mem
+	MTVU_VU_COMPILE_AHEAD, // A VIF MPG transfer is complete
 	MTVU_VIF_WRITE_COL,  // Write to Vif col reg
 	MTVU_VIF_WRITE_ROW,  // Write to Vif row reg
 	MTVU_VIF_UNPACK,     // Execute Vif Unpack
+	MTVU_VIF_UNPACK_REF, // Execute Vif Unpack of data left in EE RAM
 	MTVU_NULL_PACKET,    // Go back to beginning of buffer
 	MTVU_RESET
 };
@@ -67,6 +95,7 @@ void SaveStateBase::mtvuFreeze()
 	{
 		unsigned int v = vu1Thread.vuCycles[i].load();
 		Freeze(v);
+		vu1Thread.vuCycles[i].store(v);
 	}
 
 	u32 gsInterrupts = vu1Thread.gsInterrupts.load();
@@ -80,13 +109,41 @@ void SaveStateBase::mtvuFreeze()
 	vu1Thread.gsLabel.store(gsLabel);
 
 	Freeze(vu1Thread.vuCycleIdx);
+
+	// Deterministic mode: a kick that is done, but not due yet
+	u32 kicksPending = vu1Thread.kicksIssued - vu1Thread.kicksPinned;
+	Freeze(kicksPending);
+	if (kicksPending)
+	{
+		Freeze(vu1Thread.kickIssueCycle);
+		Freeze(vu1Thread.kickResult);
+	}
+	if (!IsSaving())
+	{
+		vu1Thread.kicksIssued = kicksPending;
+		vu1Thread.kicksDone.store(kicksPending, std::memory_order_release);
+	}
 }
 
 VU_Thread::VU_Thread(BaseVUmicroCPU*& _vuCPU, VURegs& _vuRegs)
-	: vuCPU(_vuCPU)
+	: buffer(NULL)
+	, buffer_size(0)
+	, m_parked(false)
+	, vuCPU(_vuCPU)
 	, vuRegs(_vuRegs)
+	, m_ee_spin(spin_min)
+	, m_vu_spin(spin_min)
 {
 	m_name = L"MTVU";
+	m_stats.crc = 0;
+	m_stats.since = SubsystemTiming::Now();
+	m_stats.eeStallTicks = 0;
+	m_stats.eeStalls = 0;
+	m_stats.highWater = 0;
+	m_stats.vuIdleTicks = 0;
+	m_stats.vuParks = 0;
+	m_stats.unpackRefBytes = 0;
+	m_stats.unpackCopyBytes = 0;
 #ifndef __LIBRETRO__
 	Reset();
 #endif
@@ -99,6 +156,24 @@ VU_Thread::~VU_Thread()
 		pxThread::Cancel();
 	}
 	DESTRUCTOR_CATCHALL
+	safe_aligned_free(buffer);
+}
+
+// (Re)allocates the ring for the configured size.  Only called while the ring is empty.
+void VU_Thread::ResizeRing()
+{
+	s32 size = (EmuConfig.Speedhacks.vuThreadRingSize * _1mb) / sizeof(u32);
+	if (size < (s32)(_1mb / sizeof(u32)) || (size & (size - 1)))
+		size = (_1mb * 16) / sizeof(u32);
+	if (buffer && size == buffer_size)
+		return;
+
+	safe_aligned_free(buffer);
+	buffer = (u32*)_aligned_malloc(size * sizeof(u32), 64);
+	if (!buffer)
+		throw Exception::OutOfMemory(L"MTVU ring buffer");
+	buffer_size = size;
+	m_stats.highWater = 0;
 }
 
 void VU_Thread::Reset()
@@ -111,15 +186,24 @@ void VU_Thread::Reset()
 	m_write_pos = 0;
 	m_ato_read_pos = 0;
 	m_read_pos = 0;
+	m_ahead_latched = false;
+	m_ahead_done = false;
+	m_ee_waiting = false;
+	m_ram_refs = false;
+	ResizeRing();
 	memzero(vif);
 	memzero(vifRegs);
 	for (size_t i = 0; i < 4; ++i)
 		vu1Thread.vuCycles[i] = 0;
 	vu1Thread.gsInterrupts = 0;
+	kicksDone = 0;
+	kicksIssued = 0;
+	kicksPinned = 0;
 }
 
 void VU_Thread::ExecuteTaskInThread()
 {
+	SubsystemTiming::Switch(SubsystemTiming::VU1Idle);
 	PCSX2_PAGEFAULT_PROTECT
 	{
 		ExecuteRingBuffer();
@@ -131,8 +215,25 @@ void VU_Thread::ExecuteRingBuffer()
 {
 	for (;;)
 	{
-		semaEvent.WaitWithoutYield();
+		const u64 idleStart = SubsystemTiming::Now();
+		if (!SpinUntil(m_vu_spin, [this] { return m_ato_read_pos.load(std::memory_order_relaxed) != GetWritePos(); }))
+		{
+			// The EE only posts semaEvent when it sees m_parked, so every post matches one wait.
+			// Check the ring once more after raising the flag: work queued in between would
+			// otherwise go unnoticed until the next kick.
+			m_parked.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_ato_read_pos.load(std::memory_order_relaxed) == GetWritePos())
+			{
+				semaEvent.WaitWithoutYield();
+				m_stats.vuParks.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (!m_parked.exchange(false))
+				semaEvent.WaitWithoutYield(); // A kick raced the check and posted already
+		}
+		m_stats.vuIdleTicks.fetch_add(SubsystemTiming::Now() - idleStart, std::memory_order_relaxed);
 		ScopedLockBool lock(mtxBusy, isBusy);
+		SubsystemTiming::Scope timing(SubsystemTiming::VU1Busy);
 		while (m_ato_read_pos.load(std::memory_order_relaxed) != GetWritePos())
 		{
 			u32 tag = Read();
@@ -141,6 +242,8 @@ void VU_Thread::ExecuteRingBuffer()
 			case MTVU_VU_EXECUTE:
 			{
 				vuRegs.cycle = 0;
+				m_ahead_latched = false;
+				m_ahead_done = false;
 				s32 addr = Read();
 				vifRegs.top = Read();
 				vifRegs.itop = Read();
@@ -151,6 +254,16 @@ void VU_Thread::ExecuteRingBuffer()
 				vuCPU->Execute(vu1RunCycles);
 				gifUnit.gifPath[GIF_PATH_1].FinishGSPacketMTVU();
 				semaXGkick.Post(); // Tell MTGS a path1 packet is complete
+				if (EmuConfig.DeterministicSync)
+				{
+					KickResult& result = kickResult;
+					result.cycles = vuRegs.cycle;
+					result.interrupts = gsInterrupts.exchange(0, std::memory_order_acquire);
+					result.signal = gsSignal.load(std::memory_order_relaxed);
+					result.label = gsLabel.exchange(0, std::memory_order_relaxed);
+					kicksDone.fetch_add(1, std::memory_order_release);
+					break;
+				}
 				vuCycles[vuCycleIdx].store(vuRegs.cycle, std::memory_order_release);
 				vuCycleIdx = (vuCycleIdx + 1) & 3;
 				break;
@@ -160,9 +273,28 @@ void VU_Thread::ExecuteRingBuffer()
 				u32 vu_micro_addr = Read();
 				u32 size = Read();
 				vuCPU->Clear(vu_micro_addr, size);
+				vuMicroHashRemove(1, vu_micro_addr, size);
 				Read(&vuRegs.Micro[vu_micro_addr], size);
+				vuMicroHashAdd(1, vu_micro_addr, size);
+				if (size > sizeof(u128) && !m_ahead_latched) // VIF MPG, not a write from the EE
+				{
+					m_ahead_pc = vu_micro_addr;
+					m_ahead_latched = true;
+				}
 				break;
 			}
+			case MTVU_VU_COMPILE_AHEAD:
+				// Compile the microcode uploaded first since the last execution, so the MSCAL
+				// that runs it doesn't have to.  Only when the EE neither queued anything else
+				// nor waits for us: the read position isn't committed until the compile is done,
+				// so that WaitVU never returns while it touches the recompiler.
+				if (m_ahead_latched && !m_ahead_done && m_read_pos == GetWritePos()
+					&& !m_ee_waiting.load(std::memory_order_relaxed))
+				{
+					m_ahead_done = true;
+					vuCPU->CompileAhead(m_ahead_pc);
+				}
+				break;
 			case MTVU_VU_WRITE_DATA:
 			{
 				u32 vu_data_addr = Read();
@@ -186,61 +318,96 @@ void VU_Thread::ExecuteRingBuffer()
 				m_read_pos += size_u32(size);
 				break;
 			}
+			case MTVU_VIF_UNPACK_REF:
+			{
+				u32 vif_copy_size = (uptr)&vif.StructEnd - (uptr)&vif.tag;
+				Read(&vif.tag, vif_copy_size);
+				ReadRegs(&vifRegs);
+				void* data;
+				Read(&data, sizeof(data));
+				MTVU_Unpack(data, vifRegs);
+				break;
+			}
 			case MTVU_NULL_PACKET:
 				m_read_pos = 0;
 				break;
 				jNO_DEFAULT;
 			}
 
+			// Use the idle time for the program cache, one program at a time and under the
+			// same conditions as MTVU_VU_COMPILE_AHEAD
+			if (m_read_pos == GetWritePos() && !m_ee_waiting.load(std::memory_order_relaxed))
+				vuCPU->CompileCached();
+
 			CommitReadPos();
 		}
+
 	}
 }
 
 
+__fi bool VU_Thread::HasSpace(s32 readPos, s32 size)
+{
+	if (readPos <= m_write_pos)
+		return true; // MTVU is reading in back of write_pos
+	// FIXME greg: there is a bug somewhere in the queue pointer
+	// management. It creates a deadlock/corruption in SotC intro (before
+	// the first menu). I added a 4KB safety net which seem to avoid to
+	// trigger the bug.
+	// Note: a wait lock instead of a yield also helps to avoid the bug.
+	return readPos > m_write_pos + size + _4kb; // Enough free front space
+}
+
 // Should only be called by ReserveSpace()
 __ri void VU_Thread::WaitOnSize(s32 size)
 {
-	for (;;)
+	const s32 readPos = GetReadPos();
+	const s32 used = (m_write_pos >= readPos ? 0 : buffer_size) + m_write_pos - readPos + size;
+	if ((u32)used > m_stats.highWater)
+		m_stats.highWater = used;
+	if (HasSpace(readPos, size))
+		return;
+
+	const u64 start = SubsystemTiming::Now();
+	KickStart();
+	if (!SpinUntil(m_ee_spin, [&] { return HasSpace(GetReadPos(), size); }))
 	{
-		s32 readPos = GetReadPos();
-		if (readPos <= m_write_pos)
-			break; // MTVU is reading in back of write_pos
-		// FIXME greg: there is a bug somewhere in the queue pointer
-		// management. It creates a deadlock/corruption in SotC intro (before
-		// the first menu). I added a 4KB safety net which seem to avoid to
-		// trigger the bug.
-		// Note: a wait lock instead of a yield also helps to avoid the bug.
-		if (readPos > m_write_pos + size + _4kb)
-			break; // Enough free front space
-		{          // Let MTVU run to free up buffer space
+		do
+		{ // Let MTVU run to free up buffer space
 			KickStart();
 			// Locking might trigger a full flush of the ring buffer. Yield
 			// will be more aggressive, and only flush the minimal size.
 			// Performance will be smoother but it will consume extra CPU cycle
 			// on the EE thread (not an issue on 4 cores).
 			std::this_thread::yield();
-		}
+		} while (!HasSpace(GetReadPos(), size));
 	}
+	m_stats.eeStallTicks += SubsystemTiming::Now() - start;
+	m_stats.eeStalls++;
 }
 
 // Makes sure theres enough room in the ring buffer
 // to write a continuous 'size * sizeof(u32)' bytes
 void VU_Thread::ReserveSpace(s32 size)
 {
-	pxAssert(m_write_pos < buffer_size);
-	pxAssert(size < buffer_size);
 	pxAssert(size > 0);
 
 	if (m_write_pos + size > (buffer_size - 1))
 	{
-		WaitOnSize(1); // Size of MTVU_NULL_PACKET
-		Write(MTVU_NULL_PACKET);
-		// Reset local write pointer/position
-		m_write_pos = 0;
-		CommitWritePos();
+		if (!buffer)
+			ResizeRing(); // First packet since startup, the ring is empty
+		else
+		{
+			WaitOnSize(1); // Size of MTVU_NULL_PACKET
+			Write(MTVU_NULL_PACKET);
+			// Reset local write pointer/position
+			m_write_pos = 0;
+			CommitWritePos();
+		}
 	}
 
+	pxAssert(m_write_pos < buffer_size);
+	pxAssert(size < buffer_size);
 	WaitOnSize(size);
 }
 
@@ -338,8 +505,58 @@ u32 VU_Thread::Get_vuCycles()
 		2;
 }
 
+static void MTVU_ApplySignal(u64 signal)
+{
+	GUNIT_WARN("SIGNAL firing");
+	const u32 signalMsk = (u32)(signal >> 32);
+	const u32 signalData = (u32)signal;
+	if (CSRreg.SIGNAL)
+	{
+		GUNIT_WARN("Queue SIGNAL");
+		gifUnit.gsSIGNAL.queued = true;
+#if 0
+		log_cb(RETRO_LOG_DEBUG, "Firing pending signal\n");
+#endif
+		gifUnit.gsSIGNAL.data[0] = signalData;
+		gifUnit.gsSIGNAL.data[1] = signalMsk;
+	}
+	else
+	{
+		CSRreg.SIGNAL = true;
+		GSSIGLBLID.SIGID = (GSSIGLBLID.SIGID & ~signalMsk) | (signalData & signalMsk);
+
+		if (!GSIMR.SIGMSK)
+			gsIrq();
+	}
+}
+
+static void MTVU_ApplyFinish()
+{
+	GUNIT_WARN("Finish firing");
+	CSRreg.FINISH = true;
+	gifUnit.gsFINISH.gsFINISHFired = false;
+
+	if (!gifRegs.stat.APATH)
+		Gif_FinishIRQ();
+}
+
+static void MTVU_ApplyLabel(u64 label)
+{
+	GUNIT_WARN("LABEL firing");
+	const u32 labelMsk = (u32)(label >> 32);
+	const u32 labelData = (u32)label;
+	GSSIGLBLID.LBLID = (GSSIGLBLID.LBLID & ~labelMsk) | (labelData & labelMsk);
+}
+
 void VU_Thread::Get_GSChanges()
 {
+	// In deterministic mode the interrupts travel with the kick results
+	if (EmuConfig.DeterministicSync)
+	{
+		PinDueKick();
+		return;
+	}
+
 	// Note: Atomic communication is with Gif_Unit.cpp Gif_HandlerAD_MTVU
 	u32 interrupts = gsInterrupts.load(std::memory_order_relaxed);
 	if (!interrupts)
@@ -352,37 +569,12 @@ void VU_Thread::Get_GSChanges()
 		// If load of signal was moved after clearing the flag, the other thread could write a new value before we load without noticing the double signal
 		// Prevent that with release semantics
 		gsInterrupts.fetch_and(~InterruptFlagSignal, std::memory_order_release);
-		GUNIT_WARN("SIGNAL firing");
-		const u32 signalMsk = (u32)(signal >> 32);
-		const u32 signalData = (u32)signal;
-		if (CSRreg.SIGNAL)
-		{
-			GUNIT_WARN("Queue SIGNAL");
-			gifUnit.gsSIGNAL.queued = true;
-#if 0
-			log_cb(RETRO_LOG_DEBUG, "Firing pending signal\n");
-#endif
-			gifUnit.gsSIGNAL.data[0] = signalData;
-			gifUnit.gsSIGNAL.data[1] = signalMsk;
-		} 		
-		else
-		{
-			CSRreg.SIGNAL = true;
-			GSSIGLBLID.SIGID = (GSSIGLBLID.SIGID & ~signalMsk) | (signalData & signalMsk);
-
-			if (!GSIMR.SIGMSK)
-				gsIrq();
-		}
+		MTVU_ApplySignal(signal);
 	}
 	if (interrupts & InterruptFlagFinish)
 	{
 		gsInterrupts.fetch_and(~InterruptFlagFinish, std::memory_order_relaxed);
-		GUNIT_WARN("Finish firing");
-		CSRreg.FINISH = true;
-		gifUnit.gsFINISH.gsFINISHFired = false;
-
-		if (!gifRegs.stat.APATH)
-			Gif_FinishIRQ();
+		MTVU_ApplyFinish();
 	}
 	if (interrupts & InterruptFlagLabel)
 	{
@@ -390,17 +582,65 @@ void VU_Thread::Get_GSChanges()
 		// If other thread updates gsLabel for a second interrupt, that's okay.  Worst case we think there's a label interrupt but gsLabel is 0
 		// We do not want the exchange of gsLabel to move ahead of clearing the flag, or the other thread could add more work before we clear the flag, resulting in an update with the flag unset
 		// acquire semantics should supply that guarantee
-		const u64 label = gsLabel.exchange(0, std::memory_order_relaxed);
-		GUNIT_WARN("LABEL firing");
-		const u32 labelMsk = (u32)(label >> 32);
-		const u32 labelData = (u32)label;
-		GSSIGLBLID.LBLID = (GSSIGLBLID.LBLID & ~labelMsk) | (labelData & labelMsk);
+		MTVU_ApplyLabel(gsLabel.exchange(0, std::memory_order_relaxed));
 	}
 }
 
+void VU_Thread::WaitKick()
+{
+	if (kicksDone.load(std::memory_order_acquire) != kicksPinned)
+		return;
+
+	SubsystemTiming::Scope timing(SubsystemTiming::EEWait);
+	do
+	{
+		KickStart();
+		std::this_thread::yield();
+	} while (kicksDone.load(std::memory_order_acquire) == kicksPinned);
+}
+
+void VU_Thread::PinKick()
+{
+	if (kicksPinned == kicksIssued)
+		return;
+
+	WaitKick();
+	vuCycles[vuCycleIdx].store(kickResult.cycles, std::memory_order_relaxed);
+	vuCycleIdx = (vuCycleIdx + 1) & 3;
+
+	if (kickResult.interrupts & InterruptFlagSignal)
+		MTVU_ApplySignal(kickResult.signal);
+	if (kickResult.interrupts & InterruptFlagFinish)
+		MTVU_ApplyFinish();
+	if (kickResult.interrupts & InterruptFlagLabel)
+		MTVU_ApplyLabel(kickResult.label);
+
+	kicksPinned++;
+}
+
+void VU_Thread::PinDueKick()
+{
+	if (kicksPinned == kicksIssued)
+		return;
+
+	// A VU1 running in step with the EE would be done at the issue cycle plus its own cycles
+	WaitKick();
+	if ((s32)(cpuRegs.cycle - (kickIssueCycle + kickResult.cycles)) < 0)
+		return;
+
+	PinKick();
+}
+
+// Wakes the VU thread if it's asleep.  While it's busy or still spinning it picks up new
+// work by itself, so there's nothing to post then.
 void VU_Thread::KickStart(bool forceKick)
 {
-	if ((forceKick && !semaEvent.Count()) || (!isBusy.load(std::memory_order_acquire) && GetReadPos() != m_ato_write_pos.load(std::memory_order_relaxed)))
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (!m_parked.load(std::memory_order_relaxed))
+		return;
+	if (!forceKick && GetReadPos() == m_ato_write_pos.load(std::memory_order_relaxed))
+		return;
+	if (m_parked.exchange(false))
 		semaEvent.Post();
 }
 
@@ -414,18 +654,71 @@ void VU_Thread::WaitVU()
 #if 0
 	MTVU_LOG("MTVU - WaitVU!");
 #endif
-	for (;;)
+	SubsystemTiming::Scope timing(SubsystemTiming::EEWait);
+	if (!IsDone())
 	{
-		if (IsDone())
-			break;
+		const u64 start = SubsystemTiming::Now();
+		m_ee_waiting.store(true, std::memory_order_relaxed);
+		KickStart();
+		// Once the spin gives up, park on mtxBusy, which the VU thread holds while it works
+		if (!SpinUntil(m_ee_spin, [this] { return IsDone(); }))
+		{
+			for (;;)
+			{
+				if (IsDone())
+					break;
 #if 0
-		log_cb(RETRO_LOG_DEBUG, "WaitVU()\n");
-		pxAssert(THREAD_VU1);
+				log_cb(RETRO_LOG_DEBUG, "WaitVU()\n");
+				pxAssert(THREAD_VU1);
 #endif
+				KickStart();
+				std::this_thread::yield(); // Give a chance to the MTVU thread to actually start
+				ScopedLock lock(mtxBusy);
+			}
+		}
+		m_ee_waiting.store(false, std::memory_order_relaxed);
+		m_stats.eeStallTicks += SubsystemTiming::Now() - start;
+		m_stats.eeStalls++;
+	}
+	m_ram_refs = false;
+	if (EmuConfig.DeterministicSync)
+		PinDueKick();
+}
+
+void VU_Thread::ReleaseRamRefs()
+{
+	// Writes into EE RAM all come from the EE thread, which is also the only one queuing
+	if (!m_ram_refs || IsSelf())
+		return;
+	// Not WaitVU: this runs from the page fault handler, in the middle of a store
+	while (!IsDone())
+	{
 		KickStart();
-		std::this_thread::yield(); // Give a chance to the MTVU thread to actually start
-		ScopedLock lock(mtxBusy);
+		std::this_thread::yield();
 	}
+	m_ram_refs = false;
+}
+
+void VU_Thread::ReportStats()
+{
+	const u64 now = SubsystemTiming::Now();
+	const double elapsed = (double)std::max<u64>(now - m_stats.since, 1);
+	const u64 vuIdleTicks = m_stats.vuIdleTicks.exchange(0, std::memory_order_relaxed);
+	const u32 vuParks = m_stats.vuParks.exchange(0, std::memory_order_relaxed);
+	if (m_stats.crc && m_stats.eeStalls)
+		log_cb(RETRO_LOG_INFO, "MTVU stats for %08X: EE stalled %.1f%% of the time (%u waits), VU1 idle %.1f%% (%u sleeps), ring high-water %u KB of %u KB\n",
+			m_stats.crc, m_stats.eeStallTicks * 100.0 / elapsed, m_stats.eeStalls, vuIdleTicks * 100.0 / elapsed, vuParks,
+			(u32)(m_stats.highWater * sizeof(u32) / _1kb), (u32)(buffer_size * sizeof(u32) / _1kb));
+	if (m_stats.crc && m_stats.unpackRefBytes)
+		log_cb(RETRO_LOG_INFO, "MTVU stats for %08X: VIF1 unpacks read %llu KB from EE RAM in place, copied %llu KB\n",
+			m_stats.crc, (unsigned long long)(m_stats.unpackRefBytes / _1kb), (unsigned long long)(m_stats.unpackCopyBytes / _1kb));
+	m_stats.crc = ElfCRC;
+	m_stats.since = now;
+	m_stats.eeStallTicks = 0;
+	m_stats.eeStalls = 0;
+	m_stats.highWater = 0;
+	m_stats.unpackRefBytes = 0;
+	m_stats.unpackCopyBytes = 0;
 }
 
 void VU_Thread::ExecuteVU(u32 vu_addr, u32 vif_top, u32 vif_itop)
@@ -433,7 +726,11 @@ void VU_Thread::ExecuteVU(u32 vu_addr, u32 vif_top, u32 vif_itop)
 #if 0
 	MTVU_LOG("MTVU - ExecuteVU!");
 #endif
+	if (ElfCRC != m_stats.crc)
+		ReportStats();
 	Get_GSChanges(); // Clear any pending interrupts
+	if (EmuConfig.DeterministicSync)
+		PinKick(); // VU1 finishes a program before it starts the next one
 	ReserveSpace(4);
 	Write(MTVU_VU_EXECUTE);
 	Write(vu_addr);
@@ -442,10 +739,18 @@ void VU_Thread::ExecuteVU(u32 vu_addr, u32 vif_top, u32 vif_itop)
 	CommitWritePos();
 	gifUnit.TransferGSPacketData(GIF_TRANS_MTVU, NULL, 0);
 	KickStart();
+	if (EmuConfig.DeterministicSync)
+	{
+		kickIssueCycle = cpuRegs.cycle;
+		kicksIssued++;
+	}
 	u32 cycles = std::min(Get_vuCycles(), 3000u);
 	cpuRegs.cycle += cycles * EmuConfig.Speedhacks.EECycleSkip;
 	VU0.cycle += cycles * EmuConfig.Speedhacks.EECycleSkip;
-	Get_GSChanges();
+	// In deterministic mode the kick just issued is left for the next check: finding out
+	// whether it's due already would mean waiting for it
+	if (!EmuConfig.DeterministicSync)
+		Get_GSChanges();
 }
 
 void VU_Thread::VifUnpack(vifStruct& _vif, VIFregisters& _vifRegs, u8* data, u32 size)
@@ -454,12 +759,31 @@ void VU_Thread::VifUnpack(vifStruct& _vif, VIFregisters& _vifRegs, u8* data, u32
 	MTVU_LOG("MTVU - VifUnpack!");
 #endif
 	u32 vif_copy_size = (uptr)&_vif.StructEnd - (uptr)&_vif.tag;
+
+	// Data in a write protected page of EE RAM (recompiled code lives there too) can't change
+	// before the page is unprotected, and that waits for the MTVU (see ReleaseRamRefs), so
+	// the ring only needs its address.  Anything else may be rewritten once the DMA moves on.
+	if (mmap_IsRamWriteProtected(data, size))
+	{
+		ReserveSpace(1 + size_u32(vif_copy_size) + size_u32(sizeof(VIFregistersMTVU)) + size_u32(sizeof(data)));
+		Write(MTVU_VIF_UNPACK_REF);
+		Write(&_vif.tag, vif_copy_size);
+		WriteRegs(&_vifRegs);
+		Write(&data, sizeof(data));
+		m_ram_refs = true;
+		m_stats.unpackRefBytes += size;
+		CommitWritePos();
+		KickStart();
+		return;
+	}
+
 	ReserveSpace(1 + size_u32(vif_copy_size) + size_u32(sizeof(VIFregistersMTVU)) + 1 + size_u32(size));
 	Write(MTVU_VIF_UNPACK);
 	Write(&_vif.tag, vif_copy_size);
 	WriteRegs(&_vifRegs);
 	Write(size);
 	Write(data, size);
+	m_stats.unpackCopyBytes += size;
 	CommitWritePos();
 	KickStart();
 }
@@ -478,6 +802,14 @@ void VU_Thread::WriteMicroMem(u32 vu_micro_addr, void* data, u32 size)
 	KickStart();
 }
 
+void VU_Thread::CompileAheadMicro()
+{
+	ReserveSpace(1);
+	Write(MTVU_VU_COMPILE_AHEAD);
+	CommitWritePos();
+	KickStart();
+}
+
 void VU_Thread::WriteDataMem(u32 vu_data_addr, void* data, u32 size)
 {
 #if 0
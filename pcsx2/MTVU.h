@@ -25,12 +25,13 @@
 // - This class should only be accessed from the EE thread...
 // - buffer_size must be power of 2
 // - ring-buffer has no complete pending packets when read_pos==write_pos
+// - the ring is allocated on first use and resized on Reset (Speedhacks.vuThreadRingSize)
 class VU_Thread : public pxThread {
-	static const s32 buffer_size = (_1mb * 16) / sizeof(s32);
-
-	u32 buffer[buffer_size];
+	u32* buffer;
+	s32  buffer_size; // In u32's
 	// Note: keep atomic on separate cache line to avoid CPU conflict
 	__aligned(64) std::atomic<bool> isBusy;   // Is thread processing data?
+	__aligned(64) std::atomic<bool> m_parked; // VU thread sleeps on semaEvent; cleared by whoever posts it
 	__aligned(64) std::atomic<int> m_ato_read_pos; // Only modified by VU thread
 	__aligned(64) std::atomic<int> m_ato_write_pos;    // Only modified by EE thread
 	__aligned(64) int  m_read_pos; // temporary read pos (local to the VU thread)
@@ -39,6 +40,27 @@ class VU_Thread : public pxThread {
 	Semaphore semaEvent;
 	BaseVUmicroCPU*& vuCPU;
 	VURegs&          vuRegs;
+	u32  m_ahead_pc;      // Start of the first microcode upload since the last execution (VU thread only)
+	bool m_ahead_latched; // m_ahead_pc is set
+	bool m_ahead_done;    // m_ahead_pc was compiled ahead already
+	std::atomic<bool> m_ee_waiting; // The EE is in WaitVU
+	bool m_ram_refs;      // The ring holds unpacks that read EE RAM in place (EE thread only)
+	u32  m_ee_spin;       // Adaptive spin budgets of the EE and VU thread waits (see SpinUntil)
+	u32  m_vu_spin;
+
+	// Per-title telemetry, logged by ReportStats when the game changes
+	struct Stats
+	{
+		u32 crc;
+		u64 since;                    // TSC at the start of the title
+		u64 eeStallTicks;             // EE waiting for VU1 to finish or for ring space
+		u32 eeStalls;
+		u32 highWater;                // Most of the ring in use at once, in u32's
+		u64 unpackRefBytes;           // VIF1 unpack data passed by reference to EE RAM
+		u64 unpackCopyBytes;          // VIF1 unpack data copied into the ring
+		std::atomic<u64> vuIdleTicks; // VU thread waiting for work (VU thread only)
+		std::atomic<u32> vuParks;     // Waits that outlasted the spin and slept
+	} m_stats;
 
 public:
 	__aligned16  vifStruct        vif;
@@ -57,6 +79,24 @@ public:
 	std::atomic<u64> gsLabel; // Used for GS Label command
 	std::atomic<u64> gsSignal; // Used for GS Signal command
 
+	// Deterministic mode: each VU1 kick leaves its cycle count and GS interrupts in a result
+	// slot instead of publishing them as they happen.  The EE applies them once its clock
+	// reaches the kick's issue cycle plus the VU cycles the kick took, or when it issues the
+	// next kick (VU1 finishes one program before it starts another), whichever comes first.
+	// Both points are fixed in EE time, so what the EE sees no longer depends on thread timing.
+	struct KickResult
+	{
+		u32 cycles;
+		u32 interrupts;
+		u64 signal;
+		u64 label;
+	};
+	KickResult kickResult; // Of the kick in flight; there is never more than one
+	u32 kickIssueCycle;    // EE cycle the kick in flight was issued at
+	__aligned(64) std::atomic<u32> kicksDone; // Only modified by VU thread
+	u32 kicksIssued; // Only modified by EE thread
+	u32 kicksPinned; // Only modified by EE thread
+
 	VU_Thread(BaseVUmicroCPU*& _vuCPU, VURegs& _vuRegs);
 	virtual ~VU_Thread();
 
@@ -71,8 +111,24 @@ public:
 	// Waits till MTVU is done processing
 	void WaitVU();
 
+	// Waits until no queued unpack reads EE RAM in place, before a protected page is unprotected
+	void ReleaseRamRefs();
+
+	// Logs the ring telemetry of the current title and starts counting for the running one
+	void ReportStats();
+
 	void Get_GSChanges();
 
+	// Deterministic mode: waits for the kick in flight to be done (not applied)
+	void WaitKick();
+
+	// Deterministic mode: waits for the kick in flight and applies its results
+	void PinKick();
+
+	// Deterministic mode: applies the results of the kick in flight if the EE has reached its
+	// deadline.  The deadline is only known once the kick is done, so this may wait for it.
+	void PinDueKick();
+
 	void ExecuteVU(u32 vu_addr, u32 vif_top, u32 vif_itop);
 
 	void VifUnpack(vifStruct& _vif, VIFregisters& _vifRegs, u8* data, u32 size);
@@ -80,6 +136,9 @@ public:
 	// Writes to VU's Micro Memory (size in bytes)
 	void WriteMicroMem(u32 vu_micro_addr, void* data, u32 size);
 
+	// Tells the VU thread that a VIF MPG transfer is complete (see EmuConfig.VUCompileAhead)
+	void CompileAheadMicro();
+
 	// Writes to VU's Data Memory (size in bytes)
 	void WriteDataMem(u32 vu_data_addr, void* data, u32 size);
 
@@ -93,6 +152,9 @@ protected:
 private:
 	void ExecuteRingBuffer();
 
+	void ResizeRing();
+
+	bool HasSpace(s32 readPos, s32 size);
 	void WaitOnSize(s32 size);
 	void ReserveSpace(s32 size);
 
@@ -503,7 +503,9 @@ template<int vunum> static void __fc vuMicroWrite8(u32 addr,mem8_t data) {
 	}
 	if (vu->Micro[addr]!=data) {     // Clear before writing new data
 		ClearVuFunc<vunum>(addr, 8); //(clearing 8 bytes because an instruction is 8 bytes) (cottonvibes)
+		vuMicroHashRemove(vunum, addr, sizeof(u8));
 		vu->Micro[addr] =data;
+		vuMicroHashAdd(vunum, addr, sizeof(u8));
 	}
 }
 template<int vunum> static void __fc vuMicroWrite16(u32 addr, mem16_t data) {
@@ -516,7 +518,9 @@ template<int vunum> static void __fc vuMicroWrite16(u32 addr, mem16_t data) {
 	}
 	if (*(u16*)&vu->Micro[addr]!=data) {
 		ClearVuFunc<vunum>(addr, 8);
+		vuMicroHashRemove(vunum, addr, sizeof(u16));
 		*(u16*)&vu->Micro[addr] =data;
+		vuMicroHashAdd(vunum, addr, sizeof(u16));
 	}
 }
 template<int vunum> static void __fc vuMicroWrite32(u32 addr, mem32_t data) {
@@ -529,7 +533,9 @@ template<int vunum> static void __fc vuMicroWrite32(u32 addr, mem32_t data) {
 	}
 	if (*(u32*)&vu->Micro[addr]!=data) {
 		ClearVuFunc<vunum>(addr, 8);
+		vuMicroHashRemove(vunum, addr, sizeof(u32));
 		*(u32*)&vu->Micro[addr] =data;
+		vuMicroHashAdd(vunum, addr, sizeof(u32));
 	}
 }
 template<int vunum> static void __fc vuMicroWrite64(u32 addr, const mem64_t* data) {
@@ -543,7 +549,9 @@ template<int vunum> static void __fc vuMicroWrite64(u32 addr, const mem64_t* dat
 	
 	if (*(u64*)&vu->Micro[addr]!=data[0]) {
 		ClearVuFunc<vunum>(addr, 8);
+		vuMicroHashRemove(vunum, addr, sizeof(u64));
 		*(u64*)&vu->Micro[addr] =data[0];
+		vuMicroHashAdd(vunum, addr, sizeof(u64));
 	}
 }
 template<int vunum> static void __fc vuMicroWrite128(u32 addr, const mem128_t* data) {
@@ -556,7 +564,9 @@ template<int vunum> static void __fc vuMicroWrite128(u32 addr, const mem128_t* d
 	}
 	if ((u128&)vu->Micro[addr]!=*data) {
 		ClearVuFunc<vunum>(addr, 16);
+		vuMicroHashRemove(vunum, addr, sizeof(u128));
 		CopyQWC(&vu->Micro[addr],data);
+		vuMicroHashAdd(vunum, addr, sizeof(u128));
 	}
 }
 
@@ -741,6 +751,8 @@ void eeMemoryReserve::Reset()
 
 	pxAssume( eeMem );
 
+	vtlb_Fastmem_Init();
+
 #ifdef ENABLECACHE
 	memset(pCache,0,sizeof(_cacheS)*64);
 #endif
@@ -855,6 +867,7 @@ void eeMemoryReserve::Reset()
 
 void eeMemoryReserve::Decommit()
 {
+	vtlb_Fastmem_Term();
 	_parent::Decommit();
 	eeMem = NULL;
 }
@@ -862,6 +875,7 @@ void eeMemoryReserve::Decommit()
 eeMemoryReserve::~eeMemoryReserve()
 {
 	safe_delete(mmap_faultHandler);
+	vtlb_Fastmem_Term();
 	vtlb_Term();
 }
 
@@ -902,8 +916,15 @@ struct vtlb_PageProtectionInfo
 	u32 ReverseRamMap;
 
 	vtlb_ProtectionMode Mode;
+
+	// Bit n is set if the page has recompiled code in bytes [n*SmcLineSize, (n+1)*SmcLineSize).
+	// Only ever grows until the next block tracking reset.
+	u32 CodeLines;
 };
 
+static_assert(SmcLineSize * 32 == 0x1000, "CodeLines needs one bit per line of a page");
+static_assert(sizeof(vtlb_ProtectionMode) == 4, "the EE recompiler compares Mode as a 32 bit value");
+
 static __aligned16 vtlb_PageProtectionInfo m_PageProtectInfo[Ps2MemSize::MainRam >> 12];
 
 
@@ -928,6 +949,32 @@ vtlb_ProtectionMode mmap_GetRamPageInfo( u32 paddr )
 	return m_PageProtectInfo[rampage].Mode;
 }
 
+// Returns the mode of the ram page holding paddr, for recompiled code that checks it at run time.
+const vtlb_ProtectionMode* mmap_GetRamPageModePtr( u32 paddr )
+{
+	pxAssert( eeMem );
+
+	uptr rampage = (uptr)PSM( paddr & ~0xfff ) - (uptr)eeMem->Main;
+	pxAssert( rampage < Ps2MemSize::MainRam );
+
+	return &m_PageProtectInfo[rampage >> 12].Mode;
+}
+
+// Records that [paddr, paddr+size) holds recompiled code.  The range must be inside one page.
+void mmap_MarkCodeLines( u32 paddr, u32 size )
+{
+	pxAssert( eeMem && size > 0 );
+
+	uptr ptr = (uptr)PSM( paddr );
+	int rampage = (ptr - (uptr)eeMem->Main) >> 12;
+
+	u32 first = (paddr & 0xfff) >> SmcLineShift;
+	u32 last = ((paddr & 0xfff) + size - 1) >> SmcLineShift;
+
+	for (u32 line = first; line <= last; line++)
+		m_PageProtectInfo[rampage].CodeLines |= 1u << line;
+}
+
 // paddr - physically mapped PS2 address
 void mmap_MarkCountedRamPage( u32 paddr )
 {
@@ -955,11 +1002,31 @@ void mmap_MarkCountedRamPage( u32 paddr )
 
 	m_PageProtectInfo[rampage].Mode = ProtMode_Write;
 	HostSys::MemProtect( &eeMem->Main[rampage<<12], __pagesize, PageAccess_ReadOnly() );
+	vtlb_FastmemProtect( rampage<<12, __pagesize, false );
+}
+
+// Returns true if [ptr, ptr+size) lies in EE main RAM and all of its pages are write protected,
+// so that nothing can modify it without going through mmap_ClearCpuBlock first.
+bool mmap_IsRamWriteProtected( const void* ptr, u32 size )
+{
+	pxAssert( eeMem && size > 0 );
+
+	uptr offset = (uptr)ptr - (uptr)eeMem->Main;
+	if( offset >= Ps2MemSize::MainRam || size > Ps2MemSize::MainRam - offset )
+		return false;
+
+	for( uptr rampage = offset >> 12; rampage <= (offset + size - 1) >> 12; rampage++ )
+	{
+		if( m_PageProtectInfo[rampage].Mode != ProtMode_Write )
+			return false;
+	}
+	return true;
 }
 
 // offset - offset of address relative to psM.
-// All recompiled blocks belonging to the page are cleared, and any new blocks recompiled
-// from code residing in this page will use manual protection.
+// The recompiled blocks of the line being written are cleared, and any new blocks recompiled
+// from code residing in this page will use manual protection.  The other blocks of the page
+// check their own code from now on (see memory_protect_recompiled_code).
 static __fi void mmap_ClearCpuBlock( uint offset )
 {
 	pxAssert( eeMem );
@@ -971,9 +1038,16 @@ static __fi void mmap_ClearCpuBlock( uint offset )
 	pxAssertMsg( m_PageProtectInfo[rampage].Mode != ProtMode_Manual,
 		"Attempted to clear a block that is already under manual protection." );
 
+	// VIF1 unpacks queued to the MTVU may still read the page in place
+	vu1Thread.ReleaseRamRefs();
+
 	HostSys::MemProtect( &eeMem->Main[rampage<<12], __pagesize, PageAccess_ReadWrite() );
+	vtlb_FastmemProtect( rampage<<12, __pagesize, true );
 	m_PageProtectInfo[rampage].Mode = ProtMode_Manual;
-	Cpu->Clear( m_PageProtectInfo[rampage].ReverseRamMap, 0x400 );
+
+	const u32 line = (offset & 0xfff) >> SmcLineShift;
+	recSmcPageWrite( m_PageProtectInfo[rampage].ReverseRamMap + (offset & 0xfff),
+		(m_PageProtectInfo[rampage].CodeLines >> line) & 1 );
 }
 
 void mmap_PageFaultHandler::OnPageFaultEvent( const PageFaultInfo& info, bool& handled )
@@ -982,7 +1056,13 @@ void mmap_PageFaultHandler::OnPageFaultEvent( const PageFaultInfo& info, bool& h
 
 	// get bad virtual address
 	uptr offset = info.addr - (uptr)eeMem->Main;
-	if( offset >= Ps2MemSize::MainRam ) return;
+	if( offset >= Ps2MemSize::MainRam )
+	{
+		// Stores through a fastmem view of a protected page.
+		u32 ramoffset;
+		if( !vtlb_FastmemGetRamOffset( info.addr, ramoffset ) ) return;
+		offset = ramoffset;
+	}
 
 	mmap_ClearCpuBlock( offset );
 	handled = true;
@@ -997,6 +1077,8 @@ void mmap_ResetBlockTracking()
 #if 0
 	log_cb(RETRO_LOG_DEBUG, "vtlb/mmap: Block Tracking reset...\n" );
 #endif
+	vu1Thread.ReleaseRamRefs();
 	memzero( m_PageProtectInfo );
 	if (eeMem) HostSys::MemProtect( eeMem->Main, Ps2MemSize::MainRam, PageAccess_ReadWrite() );
+	vtlb_FastmemProtect( 0, Ps2MemSize::MainRam, true );
 }
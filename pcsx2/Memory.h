@@ -125,8 +125,20 @@ enum vtlb_ProtectionMode
 };
 
 extern vtlb_ProtectionMode mmap_GetRamPageInfo( u32 paddr );
+extern const vtlb_ProtectionMode* mmap_GetRamPageModePtr( u32 paddr );
 extern void mmap_MarkCountedRamPage( u32 paddr );
+extern void mmap_MarkCodeLines( u32 paddr, u32 size );
 extern void mmap_ResetBlockTracking();
+extern bool mmap_IsRamWriteProtected( const void* ptr, u32 size );
+
+// Protected pages remember which lines hold recompiled code, so that a write to the page
+// only has to invalidate the blocks of the line it hits.
+static const uint SmcLineShift = 7;
+static const uint SmcLineSize = 1 << SmcLineShift;
+
+// Implemented by the EE recompiler (the only user of write protection): a write into a
+// protected page at paddr has unprotected it.  hasCode is set if the written line holds code.
+extern void recSmcPageWrite( u32 paddr, bool hasCode );
 
 #define memRead8 vtlb_memRead<mem8_t>
 #define memRead16 vtlb_memRead<mem16_t>
@@ -99,6 +99,26 @@ static struct retro_input_descriptor desc[] = {
 	{0},
 };
 
+// Rewind trigger, picked with a core option: the keyboard's Backspace, or two buttons of the
+// first pad held together (all sixteen joypad ids are taken by the DualShock 2 itself).
+// The pair is noted in the pad's input descriptors, so that it shows up in the frontend.
+static const unsigned rewind_combos[][2] = {
+	{0, 0}, // keyboard
+	{RETRO_DEVICE_ID_JOYPAD_L3, RETRO_DEVICE_ID_JOYPAD_R3},
+	{RETRO_DEVICE_ID_JOYPAD_SELECT, RETRO_DEVICE_ID_JOYPAD_L3},
+	{RETRO_DEVICE_ID_JOYPAD_SELECT, RETRO_DEVICE_ID_JOYPAD_R3},
+};
+static const char* rewind_desc[][2] = {
+	{NULL, NULL},
+	{"L3 (+ R3: Rewind)", "R3 (+ L3: Rewind)"},
+	{"Select (+ L3: Rewind)", "L3 (+ Select: Rewind)"},
+	{"Select (+ R3: Rewind)", "R3 (+ Select: Rewind)"},
+};
+static int rewind_combo = 1;
+static bool rewind_desc_set = false;
+static retro_input_descriptor* rewind_desc_saved[2]; // port 0 descriptors currently renamed
+static const char* rewind_desc_plain[2];
+
 bool rumble_enabled = true;
 const uint16_t rumble_max = 0xFFFF;
 uint16_t rumble_level = 0x0;
@@ -139,6 +159,54 @@ void Update()
 	Pad::rumble_all();
 }
 
+static retro_input_descriptor* FindDescriptor(unsigned port, unsigned id)
+{
+	for (retro_input_descriptor* d = desc; d->description; d++)
+		if (d->port == port && d->device == RETRO_DEVICE_JOYPAD && d->id == id)
+			return d;
+	return NULL;
+}
+
+void SetRewindButton(int combo)
+{
+	if (combo < 0 || combo >= (int)(sizeof(rewind_combos) / sizeof(*rewind_combos)))
+		combo = 1;
+	if (combo == rewind_combo && rewind_desc_set)
+		return;
+
+	// Put back the plain names of the previous pair.
+	for (int i = 0; i < 2; i++)
+		if (rewind_desc_saved[i])
+		{
+			rewind_desc_saved[i]->description = rewind_desc_plain[i];
+			rewind_desc_saved[i] = NULL;
+		}
+
+	rewind_combo = combo;
+	if (rewind_combos[combo][0] != rewind_combos[combo][1])
+	{
+		for (int i = 0; i < 2; i++)
+		{
+			rewind_desc_saved[i] = FindDescriptor(0, rewind_combos[combo][i]);
+			rewind_desc_plain[i] = rewind_desc_saved[i]->description;
+			rewind_desc_saved[i]->description = rewind_desc[combo][i];
+		}
+	}
+
+	rewind_desc_set = true;
+	environ_cb(RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS, desc);
+}
+
+bool RewindHeld()
+{
+	const unsigned* buttons = rewind_combos[rewind_combo];
+	if (buttons[0] == buttons[1])
+		return input_cb(0, RETRO_DEVICE_KEYBOARD, 0, RETROK_BACKSPACE);
+
+	const u16 mask = input_cb(0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_MASK);
+	return (mask & (1 << buttons[0])) && (mask & (1 << buttons[1]));
+}
+
 void RumbleEnabled(bool enabled, int percent)
 {
 	rumble_enabled = enabled;
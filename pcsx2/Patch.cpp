@@ -395,4 +395,6 @@ void ApplyLoadedPatches(patch_place_type place)
 		if (i.placetopatch == place)
 			_ApplyPatch(&i);
 	}
+
+	ApplyCompiledCheats(place);
 }
@@ -120,6 +120,12 @@ extern void ApplyLoadedPatches(patch_place_type place);
 // Following ApplyLoadedPatches calls will do nothing until some LoadPatchesFrom* are invoked.
 extern void ForgetLoadedPatches();
 
+// Frontend supplied cheat codes (retro_cheat_set), see Patch_Compiled.cpp.
+// Codes are compiled once when set and run from ApplyLoadedPatches together with the pnach patches.
+extern bool SetCompiledCheat(unsigned index, bool enabled, const char* code);
+extern void ResetCompiledCheats();
+extern void ApplyCompiledCheats(patch_place_type place);
+
 // Patch loading is verbose only once after the crc changes, this makes it think that the crc changed.
 extern void PatchesVerboseReset();
 
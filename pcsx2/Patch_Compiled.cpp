@@ -0,0 +1,619 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2020  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Frontend supplied cheat codes (retro_cheat_set).
+//
+// Codes are parsed once, when the frontend hands them over, into a flat list of typed ops.
+// Multi-line raw codes (inc/dec 32, fill, copy, pointer chains) become a single op or a short
+// fixed sequence, and conditional skips are resolved to op counts, so applying a cheat on
+// vsync is a tight switch over pre-decoded fields with no string or per-line state handling.
+// Every write first compares with the current value and is dropped when it already matches.
+//
+// Accepted formats (lines separated by '+', ';' or newlines):
+// - raw (decrypted) PS2 codes: "2034A0C0 00000001", same semantics as pnach "extended" lines
+//   (see handle_extended_t in Patch_Memory.cpp). These are applied continuously.
+// - pnach lines: "patch=1,EE,2034A0C0,extended,00000001", with their own place value.
+
+#include "PrecompiledHeader.h"
+
+#define _PC_ // disables MIPS opcode macros.
+
+#include "IopCommon.h"
+#include "Patch.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "retro_messager.h"
+
+enum CheatOpCode : u8
+{
+	CHEAT_NOP = 0,
+
+	// addr, value
+	CHEAT_WRITE8,
+	CHEAT_WRITE16,
+	CHEAT_WRITE32,
+	CHEAT_WRITE64,
+	CHEAT_IOP_WRITE8,
+	CHEAT_IOP_WRITE16,
+	CHEAT_IOP_WRITE32,
+
+	// addr, value: read-modify-write
+	CHEAT_INC8,
+	CHEAT_INC16,
+	CHEAT_INC32,
+	CHEAT_DEC8,
+	CHEAT_DEC16,
+	CHEAT_DEC32,
+	CHEAT_OR8,
+	CHEAT_OR16,
+	CHEAT_AND8,
+	CHEAT_AND16,
+	CHEAT_XOR8,
+	CHEAT_XOR16,
+
+	// addr, value, count, stride, increment: addr + i * stride = value + i * increment
+	CHEAT_FILL32,
+	// addr (source), value (destination), count (bytes)
+	CHEAT_COPY8,
+
+	// addr, value, count (CheatTest): skip the next 'skip' ops when the test says so
+	CHEAT_TEST8,
+	CHEAT_TEST16,
+
+	// Pointer chains: BEGIN loads addr into the pointer register, each DEREF replaces it with
+	// *ptr + value (skipping the rest of the chain on a null pointer), PTR_WRITE stores value.
+	CHEAT_PTR_BEGIN,
+	CHEAT_PTR_DEREF,
+	CHEAT_PTR_WRITE8,
+	CHEAT_PTR_WRITE16,
+	CHEAT_PTR_WRITE32,
+};
+
+// Conditions of the D/E raw codes, named after when the following lines are skipped.
+enum CheatTest : u32
+{
+	CHEAT_SKIP_IF_NE = 0,
+	CHEAT_SKIP_IF_EQ,
+	CHEAT_SKIP_IF_GE,
+	CHEAT_SKIP_IF_LE,
+};
+
+struct CheatOp
+{
+	CheatOpCode code;
+	u16 skip;
+	u32 addr;
+	u64 value;
+	u32 count;
+	u32 stride;
+	u32 increment;
+};
+
+struct CheatLine
+{
+	patch_cpu_type cpu;
+	patch_data_type type;
+	u32 addr;
+	u64 data;
+};
+
+struct CompiledCheat
+{
+	bool enabled;
+	std::vector<CheatOp> ops[_PPT_END_MARKER];
+};
+
+static std::mutex s_cheat_mutex;
+static std::map<unsigned, CompiledCheat> s_cheats;
+// All enabled cheats back to back, per place. Skips are relative and never cross a cheat.
+static std::vector<CheatOp> s_program[_PPT_END_MARKER];
+
+// --------------------------------------------------------------------------------------
+//  Parsing
+// --------------------------------------------------------------------------------------
+static bool ParseHex(const std::string& str, u64& out)
+{
+	if (str.empty() || str.size() > 16)
+		return false;
+
+	char* end;
+	out = strtoull(str.c_str(), &end, 16);
+	return *end == 0;
+}
+
+static std::string Trim(const std::string& str)
+{
+	size_t first = 0, last = str.size();
+	while (first < last && isspace((unsigned char)str[first]))
+		first++;
+	while (last > first && isspace((unsigned char)str[last - 1]))
+		last--;
+	return str.substr(first, last - first);
+}
+
+static std::vector<std::string> Split(const std::string& str, const char* separators)
+{
+	std::vector<std::string> pieces;
+	size_t pos = 0;
+	while (pos <= str.size())
+	{
+		size_t end = str.find_first_of(separators, pos);
+		if (end == std::string::npos)
+			end = str.size();
+		std::string piece = Trim(str.substr(pos, end - pos));
+		if (!piece.empty())
+			pieces.push_back(piece);
+		pos = end + 1;
+	}
+	return pieces;
+}
+
+// patch=<place>,<cpu>,<addr>,<type>,<value>
+static bool ParsePnachLine(const std::string& line, int& place, CheatLine& out)
+{
+	std::vector<std::string> pieces = Split(line.substr(line.find('=') + 1), ",");
+	if (pieces.size() < 5)
+		return false;
+
+	place = atoi(pieces[0].c_str());
+	if (place < 0 || place >= _PPT_END_MARKER)
+		return false;
+
+	if (pieces[1] == "EE")
+		out.cpu = CPU_EE;
+	else if (pieces[1] == "IOP")
+		out.cpu = CPU_IOP;
+	else
+		return false;
+
+	if (pieces[3] == "byte")
+		out.type = BYTE_T;
+	else if (pieces[3] == "short")
+		out.type = SHORT_T;
+	else if (pieces[3] == "word")
+		out.type = WORD_T;
+	else if (pieces[3] == "double")
+		out.type = DOUBLE_T;
+	else if (pieces[3] == "extended")
+		out.type = EXTENDED_T;
+	else
+		return false;
+
+	u64 addr;
+	if (!ParseHex(pieces[2], addr) || !ParseHex(pieces[4], out.data))
+		return false;
+	out.addr = (u32)addr;
+	return true;
+}
+
+static bool ParseCheat(const std::string& code, std::vector<CheatLine> (&lines)[_PPT_END_MARKER])
+{
+	for (const std::string& line : Split(code, "+;\r\n"))
+	{
+		if (line.compare(0, 5, "patch") == 0)
+		{
+			int place;
+			CheatLine parsed;
+			if (!ParsePnachLine(line, place, parsed))
+				return false;
+			lines[place].push_back(parsed);
+			continue;
+		}
+
+		// Raw codes, one or more "aaaaaaaa vvvvvvvv" pairs.
+		std::vector<std::string> words = Split(line, " \t:,");
+		if (words.empty() || words.size() % 2)
+			return false;
+
+		for (size_t i = 0; i < words.size(); i += 2)
+		{
+			u64 addr, data;
+			if (words[i].size() > 8 || words[i + 1].size() > 8 || !ParseHex(words[i], addr) || !ParseHex(words[i + 1], data))
+				return false;
+			lines[PPT_CONTINUOUSLY].push_back({CPU_EE, EXTENDED_T, (u32)addr, data});
+		}
+	}
+	return true;
+}
+
+// --------------------------------------------------------------------------------------
+//  Compiling
+// --------------------------------------------------------------------------------------
+class CheatCompiler
+{
+	const std::vector<CheatLine>& m_lines;
+	size_t m_pos = 0;
+
+	std::vector<CheatOp>& m_ops;
+	std::vector<size_t> m_op_line; // first source line of each op
+	std::vector<std::pair<size_t, size_t>> m_skip_fixups; // op index, first line not skipped
+
+public:
+	CheatCompiler(const std::vector<CheatLine>& lines, std::vector<CheatOp>& ops)
+		: m_lines(lines)
+		, m_ops(ops)
+	{
+	}
+
+	bool Compile()
+	{
+		while (m_pos < m_lines.size())
+		{
+			const size_t line = m_pos;
+			const size_t first_op = m_ops.size();
+
+			if (!CompileLine(m_lines[m_pos++]))
+				return false;
+
+			for (size_t i = first_op; i < m_ops.size(); i++)
+				m_op_line.push_back(line);
+		}
+
+		// Raw code conditionals skip source lines; turn that into a number of ops.
+		for (const auto& fixup : m_skip_fixups)
+		{
+			size_t target = fixup.first + 1;
+			while (target < m_ops.size() && m_op_line[target] < fixup.second)
+				target++;
+			m_ops[fixup.first].skip = (u16)(target - fixup.first - 1);
+		}
+		return true;
+	}
+
+private:
+	void Emit(CheatOpCode code, u32 addr, u64 value, u32 count = 0, u32 stride = 0, u32 increment = 0)
+	{
+		m_ops.push_back({code, 0, addr, value, count, stride, increment});
+	}
+
+	bool NextLine(CheatLine& out)
+	{
+		if (m_pos >= m_lines.size() || m_lines[m_pos].type != EXTENDED_T)
+		{
+			log_cb(RETRO_LOG_ERROR, "Cheat: incomplete multi-line code\n");
+			return false;
+		}
+		out = m_lines[m_pos++];
+		return true;
+	}
+
+	void EmitTest(CheatOpCode code, u32 addr, u32 value, u32 test, u32 lines)
+	{
+		m_skip_fixups.emplace_back(m_ops.size(), m_pos + lines);
+		Emit(code, addr, value, test);
+	}
+
+	bool CompileLine(const CheatLine& l)
+	{
+		if (l.cpu == CPU_IOP)
+		{
+			switch (l.type)
+			{
+				case BYTE_T:  Emit(CHEAT_IOP_WRITE8, l.addr, (u8)l.data); return true;
+				case SHORT_T: Emit(CHEAT_IOP_WRITE16, l.addr, (u16)l.data); return true;
+				case WORD_T:  Emit(CHEAT_IOP_WRITE32, l.addr, (u32)l.data); return true;
+				default:
+					log_cb(RETRO_LOG_ERROR, "Cheat: unsupported IOP operand size\n");
+					return false;
+			}
+		}
+
+		switch (l.type)
+		{
+			case BYTE_T:     Emit(CHEAT_WRITE8, l.addr, (u8)l.data); return true;
+			case SHORT_T:    Emit(CHEAT_WRITE16, l.addr, (u16)l.data); return true;
+			case WORD_T:     Emit(CHEAT_WRITE32, l.addr, (u32)l.data); return true;
+			case DOUBLE_T:   Emit(CHEAT_WRITE64, l.addr, l.data); return true;
+			case EXTENDED_T: return CompileExtended(l.addr, (u32)l.data);
+			default:         return false;
+		}
+	}
+
+	bool CompileExtended(u32 a, u32 d)
+	{
+		CheatLine next;
+
+		switch (a >> 28)
+		{
+			case 0x0: // 0aaaaaaa 000000vv
+				Emit(CHEAT_WRITE8, a & 0x0FFFFFFF, d & 0xFF);
+				return true;
+
+			case 0x1: // 1aaaaaaa 0000vvvv
+				Emit(CHEAT_WRITE16, a & 0x0FFFFFFF, d & 0xFFFF);
+				return true;
+
+			case 0x2: // 2aaaaaaa vvvvvvvv
+				Emit(CHEAT_WRITE32, a & 0x0FFFFFFF, d);
+				return true;
+
+			case 0x3:
+				switch (a & 0xFFFF0000)
+				{
+					case 0x30000000: Emit(CHEAT_INC8, d, a & 0xFF); return true;    // 300000vv 0aaaaaaa
+					case 0x30100000: Emit(CHEAT_DEC8, d, a & 0xFF); return true;    // 301000vv 0aaaaaaa
+					case 0x30200000: Emit(CHEAT_INC16, d, a & 0xFFFF); return true; // 3020vvvv 0aaaaaaa
+					case 0x30300000: Emit(CHEAT_DEC16, d, a & 0xFFFF); return true; // 3030vvvv 0aaaaaaa
+					case 0x30400000: // 30400000 0aaaaaaa / vvvvvvvv 00000000
+						if (!NextLine(next))
+							return false;
+						Emit(CHEAT_INC32, d, next.addr);
+						return true;
+					case 0x30500000: // 30500000 0aaaaaaa / vvvvvvvv 00000000
+						if (!NextLine(next))
+							return false;
+						Emit(CHEAT_DEC32, d, next.addr);
+						return true;
+				}
+				break;
+
+			case 0x4: // 4aaaaaaa nnnnssss / vvvvvvvv iiiiiiii
+				if (!NextLine(next))
+					return false;
+				Emit(CHEAT_FILL32, a & 0x0FFFFFFF, next.addr, d >> 16, (d & 0xFFFF) * 4, (u32)next.data);
+				return true;
+
+			case 0x5: // 5sssssss nnnnnnnn / 0ddddddd 00000000
+				if (!NextLine(next))
+					return false;
+				Emit(CHEAT_COPY8, a & 0x0FFFFFFF, next.addr & 0x0FFFFFFF, d);
+				return true;
+
+			case 0x6: // 6aaaaaaa vvvvvvvv / 000Xnnnn iiiiiiii / [iiiiiiii iiiiiiii]...
+			{
+				if (!NextLine(next))
+					return false;
+
+				const u32 size = (next.addr >> 16) & 0xF;
+				const u32 levels = (next.addr & 0xFFFF) ? (next.addr & 0xFFFF) : 1;
+				if (size > 2)
+					break;
+
+				std::vector<u32> offsets = {(u32)next.data};
+				while (offsets.size() < levels)
+				{
+					if (!NextLine(next))
+						return false;
+					offsets.push_back(next.addr);
+					if (offsets.size() < levels)
+						offsets.push_back((u32)next.data);
+				}
+
+				Emit(CHEAT_PTR_BEGIN, a & 0x0FFFFFFF, 0);
+				for (size_t i = 0; i < offsets.size(); i++)
+				{
+					Emit(CHEAT_PTR_DEREF, 0, offsets[i]);
+					m_ops.back().skip = (u16)(offsets.size() - i);
+				}
+				Emit((CheatOpCode)(CHEAT_PTR_WRITE8 + size), 0, d);
+				return true;
+			}
+
+			case 0x7:
+				switch (d & 0x00F00000)
+				{
+					case 0x00000000: Emit(CHEAT_OR8, a & 0x0FFFFFFF, d & 0xFF); return true;    // 7aaaaaaa 000000vv
+					case 0x00100000: Emit(CHEAT_OR16, a & 0x0FFFFFFF, d & 0xFFFF); return true; // 7aaaaaaa 0010vvvv
+					case 0x00200000: Emit(CHEAT_AND8, a & 0x0FFFFFFF, d & 0xFF); return true;   // 7aaaaaaa 002000vv
+					case 0x00300000: Emit(CHEAT_AND16, a & 0x0FFFFFFF, d & 0xFFFF); return true; // 7aaaaaaa 0030vvvv
+					case 0x00400000: Emit(CHEAT_XOR8, a & 0x0FFFFFFF, d & 0xFF); return true;   // 7aaaaaaa 004000vv
+					case 0x00500000: Emit(CHEAT_XOR16, a & 0x0FFFFFFF, d & 0xFFFF); return true; // 7aaaaaaa 0050vvvv
+				}
+				break;
+
+			case 0x8: case 0x9: case 0xA: case 0xB: case 0xC: case 0xD: // Daaaaaaa 00t0dddd
+				if (d & 0xFFCF0000)
+					break;
+				EmitTest(CHEAT_TEST16, a & 0x0FFFFFFF, d & 0xFFFF, d >> 20, 1);
+				return true;
+
+			case 0xE: // Ezyyvvvv taaaaaaa
+			{
+				const u32 z = (a >> 24) & 0xF;
+				if ((d >> 28) > CHEAT_SKIP_IF_LE || z > 1)
+					break;
+				if (z == 0)
+					EmitTest(CHEAT_TEST16, d & 0x0FFFFFFF, a & 0xFFFF, d >> 28, (a >> 16) & 0xFF);
+				else
+					EmitTest(CHEAT_TEST8, d & 0x0FFFFFFF, a & 0xFF, d >> 28, (a >> 16) & 0xFF);
+				return true;
+			}
+		}
+
+		// Same as the pnach path: unknown codes are ignored.
+		log_cb(RETRO_LOG_WARN, "Cheat: ignoring unsupported code %08X %08X\n", a, d);
+		return true;
+	}
+};
+
+static void RebuildProgram()
+{
+	for (int place = 0; place < _PPT_END_MARKER; place++)
+	{
+		s_program[place].clear();
+		for (const auto& cheat : s_cheats)
+		{
+			if (cheat.second.enabled)
+				s_program[place].insert(s_program[place].end(), cheat.second.ops[place].begin(), cheat.second.ops[place].end());
+		}
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  Running
+// --------------------------------------------------------------------------------------
+template <typename T>
+static __fi void CheatWrite(u32 addr, T value)
+{
+	if (vtlb_memRead<T>(addr) != value)
+		vtlb_memWrite<T>(addr, value);
+}
+
+template <typename T>
+static __fi bool CheatTestSkips(u32 addr, T value, u32 test)
+{
+	const T mem = vtlb_memRead<T>(addr);
+	switch (test)
+	{
+		case CHEAT_SKIP_IF_NE: return mem != value;
+		case CHEAT_SKIP_IF_EQ: return mem == value;
+		case CHEAT_SKIP_IF_GE: return mem >= value;
+		default:               return mem <= value;
+	}
+}
+
+static __fi bool IsValidCheatPointer(u32 ptr)
+{
+	return (ptr & 0x0FFFFFFF & 0x3FFFFFFC) != 0;
+}
+
+static void RunCheatProgram(const std::vector<CheatOp>& program)
+{
+	u32 ptr = 0;
+
+	for (size_t i = 0; i < program.size(); i++)
+	{
+		const CheatOp& op = program[i];
+
+		switch (op.code)
+		{
+			case CHEAT_WRITE8:  CheatWrite<mem8_t>(op.addr, (u8)op.value); break;
+			case CHEAT_WRITE16: CheatWrite<mem16_t>(op.addr, (u16)op.value); break;
+			case CHEAT_WRITE32: CheatWrite<mem32_t>(op.addr, (u32)op.value); break;
+
+			case CHEAT_WRITE64:
+			{
+				u64 mem;
+				memRead64(op.addr, &mem);
+				if (mem != op.value)
+					memWrite64(op.addr, &op.value);
+				break;
+			}
+
+			case CHEAT_IOP_WRITE8:
+				if (iopMemRead8(op.addr) != (u8)op.value)
+					iopMemWrite8(op.addr, (u8)op.value);
+				break;
+			case CHEAT_IOP_WRITE16:
+				if (iopMemRead16(op.addr) != (u16)op.value)
+					iopMemWrite16(op.addr, (u16)op.value);
+				break;
+			case CHEAT_IOP_WRITE32:
+				if (iopMemRead32(op.addr) != (u32)op.value)
+					iopMemWrite32(op.addr, (u32)op.value);
+				break;
+
+			case CHEAT_INC8:  memWrite8(op.addr, memRead8(op.addr) + (u8)op.value); break;
+			case CHEAT_INC16: memWrite16(op.addr, memRead16(op.addr) + (u16)op.value); break;
+			case CHEAT_INC32: memWrite32(op.addr, memRead32(op.addr) + (u32)op.value); break;
+			case CHEAT_DEC8:  memWrite8(op.addr, memRead8(op.addr) - (u8)op.value); break;
+			case CHEAT_DEC16: memWrite16(op.addr, memRead16(op.addr) - (u16)op.value); break;
+			case CHEAT_DEC32: memWrite32(op.addr, memRead32(op.addr) - (u32)op.value); break;
+
+			case CHEAT_OR8:   CheatWrite<mem8_t>(op.addr, memRead8(op.addr) | (u8)op.value); break;
+			case CHEAT_OR16:  CheatWrite<mem16_t>(op.addr, memRead16(op.addr) | (u16)op.value); break;
+			case CHEAT_AND8:  CheatWrite<mem8_t>(op.addr, memRead8(op.addr) & (u8)op.value); break;
+			case CHEAT_AND16: CheatWrite<mem16_t>(op.addr, memRead16(op.addr) & (u16)op.value); break;
+			case CHEAT_XOR8:  memWrite8(op.addr, memRead8(op.addr) ^ (u8)op.value); break;
+			case CHEAT_XOR16: memWrite16(op.addr, memRead16(op.addr) ^ (u16)op.value); break;
+
+			case CHEAT_FILL32:
+				for (u32 n = 0; n < op.count; n++)
+					CheatWrite<mem32_t>(op.addr + n * op.stride, (u32)op.value + n * op.increment);
+				break;
+
+			case CHEAT_COPY8:
+				for (u32 n = 0; n < op.count; n++)
+					CheatWrite<mem8_t>(((u32)op.value + n) & 0x0FFFFFFF, memRead8(op.addr + n));
+				break;
+
+			case CHEAT_TEST8:
+				if (CheatTestSkips<mem8_t>(op.addr, (u8)op.value, op.count))
+					i += op.skip;
+				break;
+			case CHEAT_TEST16:
+				if (CheatTestSkips<mem16_t>(op.addr, (u16)op.value, op.count))
+					i += op.skip;
+				break;
+
+			case CHEAT_PTR_BEGIN:
+				ptr = op.addr;
+				break;
+			case CHEAT_PTR_DEREF:
+			{
+				const u32 mem = memRead32(ptr & 0x0FFFFFFF);
+				if (!IsValidCheatPointer(mem))
+					i += op.skip;
+				else
+					ptr = mem + (u32)op.value;
+				break;
+			}
+			case CHEAT_PTR_WRITE8:  CheatWrite<mem8_t>(ptr, (u8)op.value); break;
+			case CHEAT_PTR_WRITE16: CheatWrite<mem16_t>(ptr, (u16)op.value); break;
+			case CHEAT_PTR_WRITE32: CheatWrite<mem32_t>(ptr, (u32)op.value); break;
+
+			default:
+				break;
+		}
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  Public API
+// --------------------------------------------------------------------------------------
+bool SetCompiledCheat(unsigned index, bool enabled, const char* code)
+{
+	CompiledCheat cheat = {enabled};
+	std::vector<CheatLine> lines[_PPT_END_MARKER];
+
+	if (!code || !ParseCheat(code, lines))
+	{
+		log_cb(RETRO_LOG_ERROR, "Cheat %u: unable to parse '%s'\n", index, code ? code : "");
+		return false;
+	}
+
+	for (int place = 0; place < _PPT_END_MARKER; place++)
+	{
+		if (!CheatCompiler(lines[place], cheat.ops[place]).Compile())
+		{
+			log_cb(RETRO_LOG_ERROR, "Cheat %u: unable to compile '%s'\n", index, code);
+			return false;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(s_cheat_mutex);
+	s_cheats[index] = std::move(cheat);
+	RebuildProgram();
+	return true;
+}
+
+void ResetCompiledCheats()
+{
+	std::lock_guard<std::mutex> lock(s_cheat_mutex);
+	s_cheats.clear();
+	RebuildProgram();
+}
+
+void ApplyCompiledCheats(patch_place_type place)
+{
+	std::lock_guard<std::mutex> lock(s_cheat_mutex);
+	RunCheatProgram(s_program[place]);
+}
@@ -53,6 +53,7 @@ Pcsx2Config::SpeedhackOptions::SpeedhackOptions()
 	IntcStat = true;
 	vuFlagHack = true;
 	vu1Instant = true;
+	vuThreadRingSize = 16;
 }
 
 Pcsx2Config::SpeedhackOptions& Pcsx2Config::SpeedhackOptions::DisableAll()
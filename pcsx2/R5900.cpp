@@ -34,6 +34,7 @@
 #include "CDVD/CDVD.h"
 #include "Patch.h"
 #include "GameDatabase.h"
+#include "Utilities/SubsystemTiming.h"
 
 #include "../DebugTools/Breakpoints.h"
 #include "R5900OpcodeTables.h"
@@ -430,16 +431,20 @@ __fi void _cpuEventTest_Shared()
 	if( EEsCycle > 0 )
 		iopEventAction = true;
 
-	iopEventTest();
-
-	if( iopEventAction )
 	{
-		//if( EEsCycle < -450 )
-		//	log_cb(RETRO_LOG_INFO, " IOP ahead by: %d cycles\n", -EEsCycle );
+		SubsystemTiming::Scope timing(SubsystemTiming::IOP);
+
+		iopEventTest();
 
-		EEsCycle = psxCpu->ExecuteBlock( EEsCycle );
+		if( iopEventAction )
+		{
+			//if( EEsCycle < -450 )
+			//	log_cb(RETRO_LOG_INFO, " IOP ahead by: %d cycles\n", -EEsCycle );
 
-		iopEventAction = false;
+			EEsCycle = psxCpu->ExecuteBlock( EEsCycle );
+
+			iopEventAction = false;
+		}
 	}
 
 	// ---- VU0 -------------
@@ -0,0 +1,235 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2020  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Rewind.h"
+
+RewindBuffer g_RewindBuffer;
+
+// Delta layout, repeated for every changed range (a range never crosses a page):
+//   u32 offset, u32 length    -- location of the range in the savestate
+//   { u16 zeros, u16 literals, u8 xor[literals] } ...  -- until length bytes are covered
+struct RewindRangeHeader
+{
+	u32 offset;
+	u32 length;
+};
+
+struct RewindRunHeader
+{
+	u16 zeros;
+	u16 literals;
+};
+
+// Literal runs absorb gaps of unchanged bytes shorter than this, since a new run costs
+// a header of its own.
+static const int RewindMinZeroRun = sizeof(RewindRunHeader);
+
+// --------------------------------------------------------------------------------------
+//  memDeltaSavingState  (implementations)
+// --------------------------------------------------------------------------------------
+memDeltaSavingState::memDeltaSavingState( VmStateBuffer& reference, std::vector<u8>& delta )
+	: SaveStateBase( reference )
+	, m_delta( delta )
+	, m_block( L"RewindBlock" )
+{
+}
+
+void memDeltaSavingState::FreezeMem( void* data, int size )
+{
+	if (!size) return;
+
+	// Anything past the previous state's end is garbage, but that's fine: XOR-ing it back
+	// in on rewind restores the same garbage, which the shorter state never reads.
+	m_memory->MakeRoomFor( m_idx + size );
+
+	EncodeRange( (const u8*)data, size );
+	m_idx += size;
+}
+
+void memDeltaSavingState::PrepBlock( int size )
+{
+	m_block.MakeRoomFor( size );
+}
+
+u8* memDeltaSavingState::GetBlockPtr()
+{
+	return m_block.GetPtr();
+}
+
+void memDeltaSavingState::CommitBlock( int size )
+{
+	FreezeMem( m_block.GetPtr(), size );
+}
+
+void memDeltaSavingState::EncodeRange( const u8* data, int size )
+{
+	u8* ref = m_memory->GetPtr();
+	uint pos = m_idx;
+
+	while (size > 0)
+	{
+		const int len = std::min<int>( size, RewindBuffer::PageSize - (pos & (RewindBuffer::PageSize - 1)) );
+		u8* dst = ref + pos;
+
+		if (memcmp( dst, data, len ) != 0)
+		{
+			const RewindRangeHeader range = { pos, (u32)len };
+			const u8* hdr = (const u8*)&range;
+			m_delta.insert( m_delta.end(), hdr, hdr + sizeof(range) );
+
+			int i = 0;
+			while (i < len)
+			{
+				RewindRunHeader run = { 0, 0 };
+				while (i < len && dst[i] == data[i]) { ++run.zeros; ++i; }
+
+				const int lit = i;
+				while (i < len)
+				{
+					int same = 0;
+					while (i + same < len && dst[i + same] == data[i + same] && same < RewindMinZeroRun) ++same;
+					if (same == RewindMinZeroRun || i + same == len) break;
+					i += same + 1;
+				}
+				run.literals = i - lit;
+
+				const size_t out = m_delta.size();
+				m_delta.resize( out + sizeof(run) + run.literals );
+				memcpy( &m_delta[out], &run, sizeof(run) );
+				for (int j = 0; j < run.literals; ++j)
+					m_delta[out + sizeof(run) + j] = dst[lit + j] ^ data[lit + j];
+			}
+
+			memcpy( dst, data, len );
+		}
+
+		pos  += len;
+		data += len;
+		size -= len;
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  RewindBuffer  (implementations)
+// --------------------------------------------------------------------------------------
+RewindBuffer::RewindBuffer()
+	: m_reference( L"RewindReference" )
+{
+	m_budget = 0;
+	m_used = 0;
+}
+
+void RewindBuffer::SetBudget( size_t bytes )
+{
+	m_budget = bytes;
+
+	if (!m_budget)
+	{
+		Reset();
+		return;
+	}
+
+	TrimToBudget();
+}
+
+void RewindBuffer::Reset()
+{
+	m_deltas.clear();
+	m_used = 0;
+	m_reference.Dispose();
+}
+
+void RewindBuffer::Capture()
+{
+	if (!m_budget) return;
+
+	if (m_reference.IsDisposed())
+	{
+		// Nothing to diff against yet.
+		memSavingState( m_reference ).FreezeAll();
+
+		if ((size_t)m_reference.GetSizeInBytes() >= m_budget)
+			log_cb( RETRO_LOG_WARN, "Rewind: a single state takes %u MB, more than the whole rewind buffer.\n",
+				(u32)(m_reference.GetSizeInBytes() / _1mb) );
+		return;
+	}
+
+	std::vector<u8> delta;
+	memDeltaSavingState( m_reference, delta ).FreezeAll();
+
+	// Nothing changed at all (ie, the game is paused): no point in a step back to here.
+	if (delta.empty()) return;
+
+	m_used += delta.size();
+	m_deltas.push_back( std::move(delta) );
+
+	TrimToBudget();
+}
+
+bool RewindBuffer::Rewind()
+{
+	if (m_deltas.empty()) return false;
+
+	ApplyDelta( m_deltas.back() );
+	m_used -= m_deltas.back().size();
+	m_deltas.pop_back();
+
+	memLoadingState( m_reference ).FreezeAll();
+	return true;
+}
+
+// The reference is as much a part of the rewind memory as the deltas are, so it counts
+// against the budget too; the oldest deltas go first.
+void RewindBuffer::TrimToBudget()
+{
+	const size_t reference = m_reference.GetSizeInBytes();
+
+	while (m_used + reference > m_budget && !m_deltas.empty())
+	{
+		m_used -= m_deltas.front().size();
+		m_deltas.pop_front();
+	}
+}
+
+void RewindBuffer::ApplyDelta( const std::vector<u8>& delta )
+{
+	u8* ref = m_reference.GetPtr();
+	const u8* src = delta.data();
+	const u8* end = src + delta.size();
+
+	while (src < end)
+	{
+		RewindRangeHeader range;
+		memcpy( &range, src, sizeof(range) );
+		src += sizeof(range);
+
+		u8* dst = ref + range.offset;
+		u8* dstEnd = dst + range.length;
+		while (dst < dstEnd)
+		{
+			RewindRunHeader run;
+			memcpy( &run, src, sizeof(run) );
+			src += sizeof(run);
+
+			dst += run.zeros;
+			for (int j = 0; j < run.literals; ++j)
+				dst[j] ^= src[j];
+
+			dst += run.literals;
+			src += run.literals;
+		}
+	}
+}
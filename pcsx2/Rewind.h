@@ -0,0 +1,109 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2020  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "SaveState.h"
+
+// --------------------------------------------------------------------------------------
+//  RewindBuffer
+// --------------------------------------------------------------------------------------
+// Keeps the most recent savestate in full (the reference) plus a ring of deltas going back
+// in time.  Each delta only holds the pages of the savestate that changed since the
+// previous snapshot (EE/IOP RAM, VU memory, GS local memory, ...), stored as the XOR of
+// the old and new page contents, run-length encoded.  Since XOR is its own inverse,
+// applying the newest delta to the reference turns it back into the previous state.
+//
+// Threading: Capture() and Rewind() must be called with the EE paused and the MTGS ring
+// flushed, same as any other savestate.  Capture() may also be called while the EE is parked
+// in deterministic lockstep (see SysMtgsThread::LockstepParkInThread), since it only reads
+// the VM state.
+//
+class RewindBuffer
+{
+	DeclareNoncopyableObject(RewindBuffer);
+
+public:
+	// Savestate pages are compared and encoded at this granularity.
+	static const uint PageSize = 0x1000;
+
+protected:
+	VmStateBuffer m_reference;
+	std::deque<std::vector<u8>> m_deltas;
+
+	size_t m_budget;    // max bytes of the reference plus deltas kept (0 = rewind disabled)
+	size_t m_used;      // bytes of deltas currently kept
+
+public:
+	RewindBuffer();
+	virtual ~RewindBuffer() = default;
+
+	void SetBudget( size_t bytes );
+	bool IsEnabled() const { return m_budget != 0; }
+
+	// Drops every snapshot, ie. on reset or after loading an unrelated state.
+	void Reset();
+
+	// Takes a snapshot of the current VM state and pushes its delta into the ring.
+	void Capture();
+
+	// Steps back one snapshot and loads it into the VM.  Returns false if there's nothing
+	// left to rewind to.
+	bool Rewind();
+
+	uint GetSnapshotCount() const { return m_deltas.size(); }
+	size_t GetUsedBytes() const { return m_used + m_reference.GetSizeInBytes(); }
+
+protected:
+	void ApplyDelta( const std::vector<u8>& delta );
+	void TrimToBudget();
+};
+
+// --------------------------------------------------------------------------------------
+//  memDeltaSavingState
+// --------------------------------------------------------------------------------------
+// Saves the VM state on top of an existing savestate (the reference), writing only the
+// pages that differ, and records the XOR of each changed page into the given delta.
+// Plugin blocks are staged in a small scratch buffer first, since plugins need somewhere
+// to write to.
+//
+class memDeltaSavingState : public SaveStateBase
+{
+	typedef SaveStateBase _parent;
+
+protected:
+	std::vector<u8>& m_delta;
+	SafeArray<u8> m_block;
+
+public:
+	virtual ~memDeltaSavingState() = default;
+	memDeltaSavingState( VmStateBuffer& reference, std::vector<u8>& delta );
+
+	void FreezeMem( void* data, int size );
+
+	void PrepBlock( int size );
+	u8* GetBlockPtr();
+	void CommitBlock( int size );
+
+	bool IsSaving() const { return true; }
+
+protected:
+	void EncodeRange( const u8* data, int size );
+};
+
+extern RewindBuffer g_RewindBuffer;
@@ -17,7 +17,6 @@
 #include "Global.h"
 
 /* Forward declaration */
-extern retro_audio_sample_t sample_cb;
 
 static const s32 tbl_XA_Factor[16][2] =
 	{
@@ -707,7 +706,7 @@ __forceinline
 
 		Out = clamp_mix(Out, SndOutVolumeShift);
 	}
-	sample_cb(Out.Left >> 12, Out.Right >> 12);
+	SndBuffer::Write(Out);
 
 	// Update AutoDMA output positioning
 	OutPos++;
@@ -0,0 +1,82 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2020  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Global.h"
+
+extern retro_audio_sample_batch_t batch_cb;
+
+StereoOut32 SndBuffer::sndTempBuffer[SndOutPacketSize];
+int SndBuffer::sndTempProgress = 0;
+
+StereoOut16 SndBuffer::m_ring[SndBuffer::RingSize];
+std::atomic<u32> SndBuffer::m_rpos(0);
+std::atomic<u32> SndBuffer::m_wpos(0);
+
+// Converts the temp buffer to 16 bits and queues it.  The ring is a multiple of the packet
+// size, so a packet never wraps.  If the frontend falls behind (ie. fast forward without
+// audio sync), new packets are dropped rather than overwriting ones it may be reading.
+void SndBuffer::_WritePacket()
+{
+	const u32 wpos = m_wpos.load(std::memory_order_relaxed);
+	const u32 rpos = m_rpos.load(std::memory_order_acquire);
+
+	if (wpos - rpos > RingSize - SndOutPacketSize)
+		return;
+
+	const __m128i* src = (const __m128i*)sndTempBuffer;
+	__m128i* dst = (__m128i*)&m_ring[wpos % RingSize];
+
+	// Two stereo samples per 128 bits in, four per 128 bits out.
+	for (int i = 0; i < SndOutPacketSize / 4; i++, src += 2)
+	{
+		const __m128i lo = _mm_srai_epi32(_mm_loadu_si128(src), SndOutVolumeShift);
+		const __m128i hi = _mm_srai_epi32(_mm_loadu_si128(src + 1), SndOutVolumeShift);
+
+		_mm_storeu_si128(dst + i, _mm_packs_epi32(lo, hi));
+	}
+
+	m_wpos.store(wpos + SndOutPacketSize, std::memory_order_release);
+}
+
+void SndBuffer::Write(const StereoOut32& Sample)
+{
+	sndTempBuffer[sndTempProgress++] = Sample;
+
+	if (sndTempProgress < SndOutPacketSize)
+		return;
+
+	sndTempProgress = 0;
+	_WritePacket();
+}
+
+void SndBuffer::Flush()
+{
+	const u32 rpos = m_rpos.load(std::memory_order_relaxed);
+	const u32 wpos = m_wpos.load(std::memory_order_acquire);
+
+	u32 count = wpos - rpos;
+	if (!count)
+		return;
+
+	const u32 start = rpos % RingSize;
+	const u32 first = std::min<u32>(count, RingSize - start);
+
+	batch_cb((const int16_t*)&m_ring[start], first);
+	if (count > first)
+		batch_cb((const int16_t*)&m_ring[0], count - first);
+
+	m_rpos.store(wpos, std::memory_order_release);
+}
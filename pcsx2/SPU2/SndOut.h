@@ -558,6 +558,34 @@ struct Stereo51Out32
 
 // =====================================================================================================
 
+// Mixer output, handed to the frontend in one batch per retro_run.
+//
+// Write() is called from the mixer (core thread) for every sample; samples are gathered
+// into packets of SndOutPacketSize, converted to 16 bits one packet at a time, and queued
+// in a ring buffer.  Flush() drains that ring through the libretro batch callback and must
+// only be called from the frontend thread.
+class SndBuffer
+{
+private:
+	// Stereo samples in the ring, enough for a few frames of EE run-ahead.
+	static const int RingSize = SndOutPacketSize * 256;
+
+	static StereoOut32 sndTempBuffer[SndOutPacketSize];
+	static int sndTempProgress;
+
+	static StereoOut16 m_ring[RingSize];
+	static std::atomic<u32> m_rpos;
+	static std::atomic<u32> m_wpos;
+
+	static void _WritePacket();
+
+public:
+	static void Write(const StereoOut32& Sample);
+	static void Flush();
+};
+
+// =====================================================================================================
+
 extern void RecordStart(std::wstring* filename);
 extern void RecordStop();
 extern void RecordWrite(const StereoOut16& sample);
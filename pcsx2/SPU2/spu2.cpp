@@ -21,8 +21,6 @@
 #include "Utilities/pxStreams.h"
 #include "AppCoreThread.h"
 
-extern retro_audio_sample_t sample_cb;
-
 int Interpolation = 4;
 unsigned int delayCycles = 4;
 
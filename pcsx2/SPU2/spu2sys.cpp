@@ -24,6 +24,7 @@
 #include "Global.h"
 #include "Dma.h"
 #include "IopDma.h"
+#include "Utilities/SubsystemTiming.h"
 
 #include "spu2.h" // needed until I figure out a nice solution for irqcallback dependencies.
 
@@ -373,7 +374,10 @@ __forceinline void TimeUpdate(u32 cClocks)
 
 		// Note: IOP does not use MMX regs, so no need to save them.
 		//SaveMMXRegs();
-		Mix();
+		{
+			SubsystemTiming::Scope timing(SubsystemTiming::SPU2);
+			Mix();
+		}
 		//RestoreMMXRegs();
 	}
 }
@@ -27,6 +27,7 @@
 
 #include "Elfheader.h"
 #include "Counters.h"
+#include "GS.h"
 
 #include "Utilities/SafeArray.inl"
 #include "SPU2/spu2.h"
@@ -234,13 +235,59 @@ SaveStateBase& SaveStateBase::FreezeInternals()
 	return *this;
 }
 
+// The GS plugin lives on the MTGS thread.  Under libretro that thread is the frontend's
+// own (retro_serialize/retro_unserialize), in which case we call into the plugin directly.
+static s32 gsDoFreeze( int mode, freezeData* data )
+{
+	if( GetMTGS().IsSelf() )
+	{
+		// Same register sync WaitGS() would have done for us on the other path.
+		if( mode == FREEZE_LOAD )
+			memcpy( RingBuffer.Regs, PS2MEM_GS, sizeof(RingBuffer.Regs) );
+
+		return GSfreeze( mode, data );
+	}
+
+	MTGS_FreezeData sstate = { data, 0 };
+	GetMTGS().Freeze( mode, sstate );
+	return sstate.retval;
+}
+
+void SaveStateBase::pluginFreeze( const char* name, s32 (*freezer)( int mode, freezeData* data ) )
+{
+	FreezeTag( name );
+
+	freezeData fP = { 0, NULL };
+	if( IsSaving() && (freezer( FREEZE_SIZE, &fP ) != 0) )
+		fP.size = 0;
+
+	Freeze( fP.size );
+	if( !fP.size ) return;
+
+	PrepBlock( fP.size );
+	fP.data = (s8*)GetBlockPtr();
+
+	if( freezer( IsSaving() ? FREEZE_SAVE : FREEZE_LOAD, &fP ) != 0 )
+		log_cb(RETRO_LOG_ERROR, " * %s: Error %s state!\n", name, IsSaving() ? "saving" : "loading");
+
+	CommitBlock( fP.size );
+}
+
+SaveStateBase& SaveStateBase::FreezePlugins()
+{
+	pluginFreeze( "GS", gsDoFreeze );
+	pluginFreeze( "SPU2", SPU2freeze );
+
+	return *this;
+}
+
 SaveStateBase& SaveStateBase::FreezeAll()
 {
 	FreezeMainMemory();
 	FreezeBios();
 	FreezeInternals();
-	//TODO: ADD BACK FREEZE PLUGINS HERE
-	
+	FreezePlugins();
+
 	return *this;
 }
 
@@ -302,6 +349,9 @@ memLoadingState::memLoadingState( const SafeArray<u8>* load_from )
 // Loading of state data from a memory buffer...
 void memLoadingState::FreezeMem( void* data, int size )
 {
+	if( size < 0 || m_idx + size > m_memory->GetSizeInBytes() )
+		throw Exception::EndOfStream( m_memory->Name );
+
 	const u8* const src = m_memory->GetPtr(m_idx);
 	m_idx += size;
 	memcpy( data, src, size );
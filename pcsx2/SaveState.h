@@ -28,7 +28,7 @@
 //  the lower 16 bit value.  IF the change is breaking of all compatibility with old
 //  states, increment the upper 16 bit value, and clear the lower 16 bits to 0.
 
-static const u32 g_SaveVersion = (0x9A1C << 16) | 0x0000;
+static const u32 g_SaveVersion = (0x9A1E << 16) | 0x0000;
 
 // this function is meant to be used in the place of GSfreeze, and provides a safe layer
 // between the GS saving function and the MTGS's needs. :)
@@ -72,6 +72,7 @@ public:
 	virtual SaveStateBase& FreezeMainMemory();
 	virtual SaveStateBase& FreezeBios();
 	virtual SaveStateBase& FreezeInternals();
+	virtual SaveStateBase& FreezePlugins();
 
 	// Loads or saves an arbitrary data type.  Usable on atomic types, structs, and arrays.
 	// For dynamically allocated pointers use FreezeMem instead.
@@ -89,14 +90,14 @@ public:
 		FreezeMem( &data, sizeof( T ) - sizeOfNewStuff );
 	}
 
-	void PrepBlock( int size );
+	virtual void PrepBlock( int size );
 
 	uint GetCurrentPos() const
 	{
 		return m_idx;
 	}
 
-	u8* GetBlockPtr()
+	virtual u8* GetBlockPtr()
 	{
 		return m_memory->GetPtr(m_idx);
 	}
@@ -106,7 +107,7 @@ public:
 		return m_memory->GetPtrEnd();
 	}
 
-	void CommitBlock( int size )
+	virtual void CommitBlock( int size )
 	{
 		m_idx += size;
 	}
@@ -157,6 +158,10 @@ protected:
 
 	void deci2Freeze();
 
+	// Size-prefixed plugin state block (GS, SPU2).  The plugin reads and writes directly
+	// from/to the savestate buffer, so no intermediate copy is made.
+	void pluginFreeze( const char* name, s32 (*freezer)( int mode, freezeData* data ) );
+
 	// Save or load PCSX2's global frame counter (g_FrameCount) along with each savestate
 	//
 	// This is to prevent any inaccuracy issues caused by having a different
@@ -165,6 +170,35 @@ protected:
 	void InputRecordingFreeze();
 };
 
+// --------------------------------------------------------------------------------------
+//  VmStateBufferRef
+// --------------------------------------------------------------------------------------
+// Wraps a block of memory owned by someone else (ie, the libretro frontend's serialize
+// buffer) so that memSavingState / memLoadingState can work on it in-place.  The block
+// is never reallocated nor freed; running out of room throws Exception::OutOfMemory.
+class VmStateBufferRef : public VmStateBuffer
+{
+	typedef VmStateBuffer _parent;
+
+public:
+	VmStateBufferRef( void* mem, int size )
+		: _parent( L"VmStateBufferRef", (u8*)mem, size )
+	{
+	}
+
+	virtual ~VmStateBufferRef()
+	{
+		// not ours to free.
+		m_ptr = NULL;
+	}
+
+protected:
+	u8* _virtual_realloc( int newsize )
+	{
+		return (newsize <= m_size) ? m_ptr : NULL;
+	}
+};
+
 // --------------------------------------------------------------------------------------
 //  Saving and Loading Specialized Implementations...
 // --------------------------------------------------------------------------------------
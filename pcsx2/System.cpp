@@ -297,6 +297,7 @@ void SysMainMemory::DecommitAll()
 
 	// On linux, the MTVU isn't empty and the thread still uses the m_ee/m_vu memory
 	vu1Thread.WaitVU();
+	vu1Thread.ReportStats();
 	// The EE thread must be stopped here command mustn't be send
 	// to the ring. Let's call it an extra safety valve :)
 	vu1Thread.Reset();
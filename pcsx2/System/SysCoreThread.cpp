@@ -30,6 +30,7 @@
 #include "FW.h"
 #include "PAD/PAD.h"
 #include "SPU2/spu2.h"
+#include "Utilities/SubsystemTiming.h"
 
 #include "../DebugTools/MIPSAnalyst.h"
 #include "../DebugTools/SymbolMap.h"
@@ -346,7 +347,11 @@ void SysCoreThread::ExecuteTaskInThread()
 	{
 		while (true)
 		{
+			// Cpu->Execute() is left through longjmp, which skips the destructors of any
+			// timing scope that was open at the time; reset the thread's counter here.
+			SubsystemTiming::Switch(SubsystemTiming::None);
 			StateCheckInThread();
+			SubsystemTiming::Switch(SubsystemTiming::EE);
 			DoCpuExecute();
 		}
 	}
@@ -150,6 +150,14 @@ public:
 	// there is another gif path 2/3 transfer already taking place.
 	// Use this method to resume execution of VU1.
 	virtual void ResumeXGkick() {}
+
+	// Compiles the program at startPC in the current micro memory before it is run, if the
+	// provider compiles at all.  Called by the MTVU thread when it is idle.
+	virtual void CompileAhead(u32 startPC) {}
+
+	// Compiles one more program the provider cached from an earlier session, if any.  Returns
+	// false when there is nothing left.  Called by the MTVU thread when its ring is drained.
+	virtual bool CompileCached() { return false; }
 };
 
 
@@ -231,6 +239,8 @@ public:
 	void Clear(u32 addr, u32 size);
 	void Vsync() noexcept;
 	void ResumeXGkick();
+	void CompileAhead(u32 startPC);
+	bool CompileCached();
 
 	uint GetCacheReserve() const;
 	void SetCacheReserve( uint reserveInMegs ) const;
@@ -253,6 +263,15 @@ extern void vu1ResetRegs();
 extern void __fastcall vu1ExecMicro(u32 addr);
 extern void vu1Exec(VURegs* VU);
 
+// Micro memory hash: a position-dependent sum over the words of each VU's micro memory, kept
+// up to date by everything that writes to VUx.Micro so microVU can look programs up by content.
+// Writers call vuMicroHashRemove before changing a range and vuMicroHashAdd after it.
+extern u64 vuMicroHash[2];
+extern u64 vuMicroHashOf(const u32* words, u32 count);
+extern void vuMicroHashRemove(int vuIndex, u32 addr, u32 size);
+extern void vuMicroHashAdd(int vuIndex, u32 addr, u32 size);
+extern void vuMicroHashReset(int vuIndex);
+
 #ifdef VUM_LOG
 
 #define IdebugUPPER(VU) \
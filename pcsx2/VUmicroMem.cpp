@@ -52,6 +52,9 @@ void vuMemoryReserve::Reset()
 	pxAssert( VU0.Mem );
 	pxAssert( VU1.Mem );
 
+	vuMicroHashReset(0);
+	vuMicroHashReset(1);
+
 	// Below memMap is already called by "void eeMemoryReserve::Reset()"
 	//memMapVUmicro();
 
@@ -76,6 +79,58 @@ void vuMemoryReserve::Reset()
 	VU1.VI[0].UL = 0;
 }
 
+u64 vuMicroHash[2];
+
+static __fi u64 vuMicroHashWord(u32 index, u32 word)
+{
+	// fmix64 from MurmurHash3, so that words moving around also change the sum
+	u64 x = ((u64)index << 32) | word;
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdull;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ull;
+	x ^= x >> 33;
+	return x;
+}
+
+u64 vuMicroHashOf(const u32* words, u32 count)
+{
+	u64 hash = 0;
+	for (u32 i = 0; i < count; i++)
+		hash += vuMicroHashWord(i, words[i]);
+	return hash;
+}
+
+// Adds (sign = 1) or removes (sign = -1) the words overlapping [addr, addr+size)
+static void vuMicroHashUpdate(int vuIndex, u32 addr, u32 size, u64 sign)
+{
+	const VURegs& vu = vuRegs[vuIndex];
+	const u32* words = (const u32*)vu.Micro;
+	const u32 count  = (vuIndex ? VU1_PROGSIZE : VU0_PROGSIZE) / 4;
+	const u32 end    = std::min((addr + size + 3) / 4, count);
+
+	u64 hash = 0;
+	for (u32 i = addr / 4; i < end; i++)
+		hash += vuMicroHashWord(i, words[i]);
+	vuMicroHash[vuIndex] += hash * sign;
+}
+
+void vuMicroHashRemove(int vuIndex, u32 addr, u32 size)
+{
+	vuMicroHashUpdate(vuIndex, addr, size, (u64)-1);
+}
+
+void vuMicroHashAdd(int vuIndex, u32 addr, u32 size)
+{
+	vuMicroHashUpdate(vuIndex, addr, size, 1);
+}
+
+void vuMicroHashReset(int vuIndex)
+{
+	const VURegs& vu = vuRegs[vuIndex];
+	vuMicroHash[vuIndex] = vuMicroHashOf((const u32*)vu.Micro, (vuIndex ? VU1_PROGSIZE : VU0_PROGSIZE) / 4);
+}
+
 void SaveStateBase::vuMicroFreeze()
 {
 	FreezeTag( "vuMicroRegs" );
@@ -93,4 +148,10 @@ void SaveStateBase::vuMicroFreeze()
 
 	Freeze(VU1.VF);
 	Freeze(VU1.VI);
+
+	// The micro memory was loaded with the main memory, and the MTVU ring is idle at this point
+	if (IsLoading()) {
+		vuMicroHashReset(0);
+		vuMicroHashReset(1);
+	}
 }
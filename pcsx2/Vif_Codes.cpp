@@ -296,10 +296,14 @@ static __fi void _vifCode_MPG(int idx, u32 addr, const u32 *data, int size) {
 		if (!idx)  CpuVU0->Clear(addr, vuMemSize - addr);
 		else	   CpuVU1->Clear(addr, vuMemSize - addr);
 		
+		vuMicroHashRemove(idx, addr, vuMemSize - addr);
 		memcpy(VUx.Micro + addr, data, vuMemSize - addr);
+		vuMicroHashAdd(idx, addr, vuMemSize - addr);
 		size -= (vuMemSize - addr) / 4;
 		data += (vuMemSize - addr) / 4;
+		vuMicroHashRemove(idx, 0, size * 4);
 		memcpy(VUx.Micro, data, size * 4);
+		vuMicroHashAdd(idx, 0, size * 4);
 
 		vifX.tag.addr = size * 4;
 	}
@@ -311,7 +315,9 @@ static __fi void _vifCode_MPG(int idx, u32 addr, const u32 *data, int size) {
 		// Clear VU memory before writing!
 		if (!idx)  CpuVU0->Clear(addr, size*4);
 		else	   CpuVU1->Clear(addr, size*4);
+		vuMicroHashRemove(idx, addr, size*4);
 		memcpy(VUx.Micro + addr, data, size*4); //from tests, memcpy is 1fps faster on Grandia 3 than memcpy
+		vuMicroHashAdd(idx, addr, size*4);
 
 		vifX.tag.addr   +=   size * 4;
 	}
@@ -346,6 +352,8 @@ vifOp(vifCode_MPG) {
 				//log_cb(RETRO_LOG_DEBUG, "Vif%d MPG Split Overflow full %x\n", idx, vifX.tag.addr + vifX.tag.size*4);
 			}
 			_vifCode_MPG(idx,  vifX.tag.addr, data, vifX.tag.size);
+			if (idx && THREAD_VU1 && EmuConfig.VUCompileAhead)
+				vu1Thread.CompileAheadMicro();
 			int ret = vifX.tag.size;
 			vifX.tag.size = 0;
 			vifX.cmd      = 0;
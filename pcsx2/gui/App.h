@@ -191,6 +191,9 @@ public:
 	bool OnInit();
 	int  OnExit();
 	void CleanUp();
+#ifdef __LIBRETRO__
+	void WakeUpIdle();
+#endif
 
 	void AllocateCoreStuffs();
 	void CleanupOnExit();
@@ -337,6 +337,7 @@ bool AppConfig::IsOkApplyPreset(int n, bool ignoreMTVU)
 	EmuOptions.Speedhacks.bitset	= 0; //Turn off individual hacks to make it visually clear they're not used.
 	EmuOptions.Speedhacks.vuThread	= original_SpeedHacks.vuThread;
 	EmuOptions.Speedhacks.vu1Instant = original_SpeedHacks.vu1Instant;
+	EmuOptions.Speedhacks.vuThreadRingSize = original_SpeedHacks.vuThreadRingSize;
 	EnableSpeedHacks = true;
 	// Actual application of current preset over the base settings which all presets use (mostly pcsx2's default values).
 
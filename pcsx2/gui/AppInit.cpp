@@ -15,6 +15,7 @@
 
 #include "PrecompiledHeader.h"
 #include "App.h"
+#include "GS.h"
 #include "MTVU.h" // for thread cancellation on shutdown
 
 #include <memory>
@@ -153,6 +154,15 @@ void Pcsx2App::CleanUp()
 {
 }
 
+#ifdef __LIBRETRO__
+// There is no wx event loop to wake up: queued events are handled by the MTGS loop on the
+// frontend thread, so kick that instead.
+void Pcsx2App::WakeUpIdle()
+{
+	GetMTGS().PostAppEvents();
+}
+#endif
+
 // ------------------------------------------------------------------------------------------
 //  Using the MSVCRT to track memory leaks:
 // ------------------------------------------------------------------------------------------
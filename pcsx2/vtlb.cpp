@@ -575,6 +575,220 @@ __fi u32 vtlb_V2P(u32 vaddr)
 	return paddr;
 }
 
+// --------------------------------------------------------------------------------------
+//  Fastmem
+// --------------------------------------------------------------------------------------
+// With fastmem enabled the whole 4GB PS2 virtual space is reserved on the host, and every
+// vmap page that points into main memory is also mapped there, at its PS2 virtual address,
+// onto the same pages as eeMem->Main (the two views share one memory object).  Recompiled
+// code can then access [vtlbdata.fastmem + vaddr] without a vtlb lookup.  All other pages
+// (scratchpad, roms, hardware registers and unmapped space) stay inaccessible; the EE
+// recompiler catches the fault and moves that access over to the vtlb path for good.
+//
+// Write protection of main memory (used to detect self modifying code) is mirrored to
+// every view of a page, so stores through fastmem fault exactly like direct stores do.
+
+static const uint FASTMEM_RAM_PAGES = Ps2MemSize::MainRam >> VTLB_PAGE_BITS;
+
+static void* s_fastmemShared = NULL;
+
+// ram page + 1 mapped at each virtual page, 0 if the virtual page isn't mapped
+static std::vector<u32> s_fastmemVPage;
+
+// virtual pages mapping each ram page
+static std::vector<u32> s_fastmemAliases[FASTMEM_RAM_PAGES];
+
+static bool s_fastmemReadOnly[FASTMEM_RAM_PAGES];
+
+static u32 vtlb_FastmemRamPage(u32 vpage)
+{
+	const u32 vaddr = vpage << VTLB_PAGE_BITS;
+	auto vmv = vtlbdata.vmap[vpage];
+	if (vmv.isHandler(vaddr))
+		return 0;
+
+	uptr offset = vmv.assumePtr(vaddr) - (uptr)eeMem->Main;
+	if (offset >= Ps2MemSize::MainRam)
+		return 0;
+
+	return (offset >> VTLB_PAGE_BITS) + 1;
+}
+
+static void vtlb_FastmemMapRun(u32 vpage, u32 count, u32 rampage)
+{
+	u8* base = vtlbdata.fastmem + ((uptr)vpage << VTLB_PAGE_BITS);
+	size_t size = (size_t)count << VTLB_PAGE_BITS;
+
+	if (!rampage)
+	{
+		HostSys::MmapResetPtr(base, size);
+		return;
+	}
+
+	const bool ro = s_fastmemReadOnly[rampage - 1];
+	if (!HostSys::MapSharedMemory(s_fastmemShared, (size_t)(rampage - 1) << VTLB_PAGE_BITS, base, size,
+			ro ? PageAccess_ReadOnly() : PageAccess_ReadWrite()))
+		log_cb(RETRO_LOG_ERROR, "vtlb: fastmem view @ 0x%08X could not be mapped\n", vpage << VTLB_PAGE_BITS);
+}
+
+// Brings the fastmem views of [vaddr, vaddr+size) in line with the vmap.  Consecutive pages
+// onto consecutive ram pages with the same protection are mapped with a single call.
+static void vtlb_FastmemRemap(u32 vaddr, u32 size)
+{
+	if (!vtlbdata.fastmem)
+		return;
+
+	const u32 first = vaddr >> VTLB_PAGE_BITS;
+	const u32 count = size >> VTLB_PAGE_BITS;
+
+	u32 runStart = 0, runLength = 0, runRam = 0;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		const u32 vpage = first + i;
+		const u32 old = s_fastmemVPage[vpage];
+		const u32 ram = vtlb_FastmemRamPage(vpage);
+
+		bool extends = runLength && vpage == runStart + runLength;
+		if (extends)
+		{
+			if (runRam && ram)
+				extends = ram == runRam + runLength && s_fastmemReadOnly[ram - 1] == s_fastmemReadOnly[runRam - 1];
+			else
+				extends = !runRam && !ram;
+		}
+
+		if (old == ram)
+			continue;
+
+		if (!extends)
+		{
+			if (runLength)
+				vtlb_FastmemMapRun(runStart, runLength, runRam);
+			runStart = vpage;
+			runLength = 0;
+			runRam = ram;
+		}
+		runLength++;
+
+		if (old)
+		{
+			auto& aliases = s_fastmemAliases[old - 1];
+			aliases.erase(std::find(aliases.begin(), aliases.end(), vpage));
+		}
+		if (ram)
+			s_fastmemAliases[ram - 1].push_back(vpage);
+		s_fastmemVPage[vpage] = ram;
+	}
+
+	if (runLength)
+		vtlb_FastmemMapRun(runStart, runLength, runRam);
+}
+
+// Sets up the fastmem views, or tears them down if fastmem got disabled.  Must be called
+// after eeMem has been committed and cleared, and before the vmap is set up.
+void vtlb_Fastmem_Init()
+{
+	if (!EmuConfig.EEFastmem)
+	{
+		vtlb_Fastmem_Term();
+		return;
+	}
+
+	if (!vtlbdata.fastmem)
+	{
+		if (!s_fastmemShared)
+			s_fastmemShared = HostSys::CreateSharedMemory(Ps2MemSize::MainRam);
+
+		// (MmapReserve passes on mmap's MAP_FAILED on Linux)
+		void* base = s_fastmemShared ? HostSys::MmapReserve(0, _4gb) : NULL;
+		if (!base || base == (void*)-1)
+		{
+			log_cb(RETRO_LOG_WARN, "vtlb: fastmem is not available on this system, using the vtlb for all accesses.\n");
+			return;
+		}
+
+		vtlbdata.fastmem = (u8*)base;
+		s_fastmemVPage.assign(VTLB_VMAP_ITEMS, 0);
+
+		// eeMem->Main itself becomes a view of the (zero filled) shared pages.  Its contents
+		// were just cleared anyway.
+		if (!HostSys::MapSharedMemory(s_fastmemShared, 0, eeMem->Main, Ps2MemSize::MainRam, PageAccess_ReadWrite()))
+		{
+			log_cb(RETRO_LOG_ERROR, "vtlb: main memory could not be remapped for fastmem.\n");
+			vtlb_Fastmem_Term();
+			return;
+		}
+
+		log_cb(RETRO_LOG_INFO, "vtlb: fastmem enabled @ %p\n", base);
+	}
+	else
+	{
+		HostSys::MmapResetPtr(vtlbdata.fastmem, _4gb);
+		std::fill(s_fastmemVPage.begin(), s_fastmemVPage.end(), 0);
+	}
+
+	for (auto& aliases : s_fastmemAliases)
+		aliases.clear();
+	memzero(s_fastmemReadOnly);
+}
+
+void vtlb_Fastmem_Term()
+{
+	if (vtlbdata.fastmem)
+	{
+		HostSys::Munmap(vtlbdata.fastmem, _4gb);
+		vtlbdata.fastmem = NULL;
+		s_fastmemVPage.clear();
+		s_fastmemVPage.shrink_to_fit();
+		for (auto& aliases : s_fastmemAliases)
+			aliases.clear();
+	}
+
+	// eeMem->Main keeps its own reference to the shared pages, if it was mapped onto them.
+	HostSys::DestroySharedMemory(s_fastmemShared);
+	s_fastmemShared = NULL;
+}
+
+// Mirrors a protection change of [ramoffset, ramoffset+size) in eeMem->Main to its fastmem views.
+void vtlb_FastmemProtect(u32 ramoffset, u32 size, bool writable)
+{
+	if (!vtlbdata.fastmem)
+		return;
+
+	const u32 first = ramoffset >> VTLB_PAGE_BITS;
+	const u32 last = (ramoffset + size - 1) >> VTLB_PAGE_BITS;
+
+	for (u32 rampage = first; rampage <= last; rampage++)
+	{
+		if (s_fastmemReadOnly[rampage] == !writable)
+			continue;
+
+		s_fastmemReadOnly[rampage] = !writable;
+		for (u32 vpage : s_fastmemAliases[rampage])
+			HostSys::MemProtect(vtlbdata.fastmem + ((uptr)vpage << VTLB_PAGE_BITS), __pagesize,
+				writable ? PageAccess_ReadWrite() : PageAccess_ReadOnly());
+	}
+}
+
+// Translates a host address inside a fastmem view of main memory to its offset in eeMem->Main.
+bool vtlb_FastmemGetRamOffset(uptr hostaddr, u32& ramoffset)
+{
+	if (!vtlbdata.fastmem)
+		return false;
+
+	uptr vaddr = hostaddr - (uptr)vtlbdata.fastmem;
+	if (vaddr >= (uptr)_4gb)
+		return false;
+
+	u32 ram = s_fastmemVPage[vaddr >> VTLB_PAGE_BITS];
+	if (!ram)
+		return false;
+
+	ramoffset = ((ram - 1) << VTLB_PAGE_BITS) | (vaddr & VTLB_PAGE_MASK);
+	return true;
+}
+
 //virtual mappings
 //TODO: Add invalid paddr checks
 void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
@@ -583,6 +797,8 @@ void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
 	verify(0==(paddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 vstart = vaddr, vsize = size;
+
 	while (size > 0)
 	{
 		VTLBVirtual vmv;
@@ -605,6 +821,8 @@ void vtlb_VMap(u32 vaddr,u32 paddr,u32 size)
 		paddr += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+
+	vtlb_FastmemRemap(vstart, vsize);
 }
 
 void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
@@ -612,6 +830,8 @@ void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
 	verify(0==(vaddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 vstart = vaddr, vsize = size;
+
 	uptr bu8 = (uptr)buffer;
 	while (size > 0)
 	{
@@ -620,6 +840,8 @@ void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 size)
 		bu8 += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+
+	vtlb_FastmemRemap(vstart, vsize);
 }
 
 void vtlb_VMapUnmap(u32 vaddr,u32 size)
@@ -627,6 +849,8 @@ void vtlb_VMapUnmap(u32 vaddr,u32 size)
 	verify(0==(vaddr&VTLB_PAGE_MASK));
 	verify(0==(size&VTLB_PAGE_MASK) && size>0);
 
+	const u32 vstart = vaddr, vsize = size;
+
 	while (size > 0)
 	{
 
@@ -641,6 +865,8 @@ void vtlb_VMapUnmap(u32 vaddr,u32 size)
 		vaddr += VTLB_PAGE_SIZE;
 		size -= VTLB_PAGE_SIZE;
 	}
+
+	vtlb_FastmemRemap(vstart, vsize);
 }
 
 // vtlb_Init -- Clears vtlb handlers and memory mappings.
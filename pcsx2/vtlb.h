@@ -83,6 +83,12 @@ extern void vtlb_VMap(u32 vaddr,u32 paddr,u32 sz);
 extern void vtlb_VMapBuffer(u32 vaddr,void* buffer,u32 sz);
 extern void vtlb_VMapUnmap(u32 vaddr,u32 sz);
 
+//fastmem
+extern void vtlb_Fastmem_Init();
+extern void vtlb_Fastmem_Term();
+extern void vtlb_FastmemProtect(u32 ramoffset, u32 size, bool writable);
+extern bool vtlb_FastmemGetRamOffset(uptr hostaddr, u32& ramoffset);
+
 //Memory functions
 
 template< typename DataType >
@@ -103,6 +109,25 @@ extern void vtlb_DynGenWrite_Const( u32 bits, u32 addr_const );
 extern void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const );
 extern void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const );
 
+extern void vtlb_DynGenFastmemStubs();
+extern void vtlb_DynGenFastmemClear(uptr start, uptr end);
+
+// A fast access of recompiled code: the instruction that can fault, the start of its site and
+// the stub the site is backpatched to (see vtlb_DynGenFastmemStubs).
+struct vtlb_FastmemSite
+{
+	uptr access;
+	uptr start;
+	uptr stub;
+};
+
+extern void vtlb_DynGenFastmemGetSites(uptr start, uptr end, std::vector<vtlb_FastmemSite>& sites);
+extern void vtlb_DynGenFastmemAddSite(const vtlb_FastmemSite& site);
+
+// Records the pages the _Const accesses resolve through vtlbdata.vmap at compile time, while
+// pages isn't NULL (see RecBlockCache).
+extern void vtlb_DynGenTrackConstPages(std::vector<u32>* pages);
+
 // --------------------------------------------------------------------------------------
 //  VtlbMemoryReserve
 // --------------------------------------------------------------------------------------
@@ -252,10 +277,13 @@ namespace vtlb_private
 
 		u32* ppmap;               //4MB (allocated by vtlb_init) // PS2 virtual to PS2 physical
 
+		u8* fastmem;              //4GB (reserved by vtlb_Fastmem_Init) // PS2 virtual mapped 1:1, NULL if disabled
+
 		MapData()
 		{
 			vmap = NULL;
 			ppmap = NULL;
+			fastmem = NULL;
 		}
 	};
 
@@ -138,6 +138,25 @@ public:
 
 		_Size -= range;
 	}
+
+	// Removes every block for which pred returns true, keeping the others in order.
+	template <typename Pred>
+	s32 erase_if(Pred pred)
+	{
+		s32 kept = 0;
+
+		for (s32 i = 0; i < _Size; i++) {
+			if (pred(blocks[i]))
+				continue;
+			if (kept != i)
+				blocks[kept] = blocks[i];
+			kept++;
+		}
+
+		s32 removed = _Size - kept;
+		_Size = kept;
+		return removed;
+	}
 };
 
 class BaseBlocks
@@ -211,6 +230,34 @@ public:
 
 	void Link(u32 pc, s32* jumpptr);
 
+	// Removes the blocks whose code lies in [start, end), so that part of the code cache can
+	// be reused.  Jumps to them go back to the recompiler and the links emitted inside the
+	// range are forgotten.  onRemove gets each removed block, to reset its LUT entry.
+	template <typename F>
+	int RemoveCode(uptr start, uptr end, F onRemove)
+	{
+		int removed = blocks.erase_if([&](const BASEBLOCKEX& block) {
+			if (block.fnptr < start || block.fnptr >= end)
+				return false;
+
+			std::pair<linkiter_t, linkiter_t> range = links.equal_range(block.startpc);
+			for (linkiter_t i = range.first; i != range.second; ++i)
+				*(u32*)i->second = recompiler - (i->second + 4);
+
+			onRemove(block);
+			return true;
+		});
+
+		for (linkiter_t i = links.begin(); i != links.end();) {
+			if (i->second >= start && i->second < end)
+				i = links.erase(i);
+			else
+				++i;
+		}
+
+		return removed;
+	}
+
 	__fi void Reset()
 	{
 		blocks.clear();
@@ -15,6 +15,10 @@
 
 #pragma once
 #include "Pcsx2Defs.h"
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // Keep my nice alignment please!
 #define MOVZ MOVZtemp
@@ -230,3 +234,149 @@ struct eeProfiler {
 	__fi void EmitSlowMem() {}
 	__fi void EmitFastMem() {}
 };
+
+// --------------------------------------------------------------------------------------
+//  eeBlockProfiler
+// --------------------------------------------------------------------------------------
+// Optional per-block execution profile of the EE recompiler (EmuConfig.EEBlockProfiler).
+// Every block compiled while it is enabled calls Enter() on entry.  Hits are counted
+// exactly; time is sampled: one execution out of SampleRate is timed from its entry to the
+// next block entry, which includes the dispatcher and event test work that follows it.
+//
+// Profiles are keyed by startpc and survive block clears and recompiler resets, so a block
+// that gets recompiled (self-modifying code, overlays) keeps accumulating into one entry.
+// Threading: EE thread only.
+
+struct eeBlockProfile
+{
+	u32 startpc;
+	u16 size;     // guest instructions, as of the last compile
+	u16 x86size;  // bytes of x86 code, as of the last compile
+	u32 compiles;
+	u64 hits;
+	u64 samples;
+	u64 ticks;    // TSC ticks of the sampled executions
+	std::vector<const char*> interpOps; // instructions compiled as interpreter calls
+
+	// Estimated TSC ticks spent in the block over all its hits
+	u64 Cost() const { return samples ? (u64)((double)ticks / samples * hits) : 0; }
+};
+
+struct eeBlockProfiler
+{
+	static const u64 SampleRate = 64; // power of 2
+
+	std::unordered_map<u32, eeBlockProfile> blocks;
+	eeBlockProfile* current;  // block being compiled
+	eeBlockProfile* timed;    // block whose sampled execution is running
+	u64 timedStart;
+
+	eeBlockProfiler() : current(NULL), timed(NULL), timedStart(0) {}
+
+	void Reset()
+	{
+		blocks.clear();
+		current = NULL;
+		timed = NULL;
+	}
+
+	// Recompiler: a new block starts at startpc.  unordered_map never moves its elements,
+	// so the returned pointer can be baked into the block's code.
+	eeBlockProfile* BeginBlock(u32 startpc)
+	{
+		eeBlockProfile& prof = blocks[startpc];
+		prof.startpc = startpc;
+		prof.compiles++;
+		prof.interpOps.clear();
+		current = &prof;
+		return current;
+	}
+
+	void EndBlock(u16 size, u16 x86size)
+	{
+		if (!current)
+			return;
+		current->size = size;
+		current->x86size = x86size;
+		current = NULL;
+	}
+
+	// Recompiler: the current instruction is compiled as a call to its interpreter handler
+	void EmitInterpOp(const char* name)
+	{
+		if (!current)
+			return;
+		std::vector<const char*>& ops = current->interpOps;
+		if (std::find(ops.begin(), ops.end(), name) == ops.end())
+			ops.push_back(name);
+	}
+
+	// Called by the timed block's successor, or when execution leaves recompiled code
+	__fi void CloseSample(u64 now)
+	{
+		timed->ticks += now - timedStart;
+		timed->samples++;
+		timed = NULL;
+	}
+
+	__fi void Enter(eeBlockProfile* prof)
+	{
+		if (timed)
+			CloseSample(__rdtsc());
+		if ((++prof->hits & (SampleRate - 1)) == 0)
+		{
+			timed = prof;
+			timedStart = __rdtsc();
+		}
+	}
+
+	// Execution left recompiled code (pause, exception); a sample spanning it would be bogus
+	void CancelSample() { timed = NULL; }
+
+	void Print(uint count = 64) const
+	{
+		if (blocks.empty())
+			return;
+
+		std::vector<const eeBlockProfile*> sorted;
+		sorted.reserve(blocks.size());
+		u64 totalHits = 0, totalCost = 0;
+		for (const auto& it : blocks)
+		{
+			sorted.push_back(&it.second);
+			totalHits += it.second.hits;
+			totalCost += it.second.Cost();
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const eeBlockProfile* a, const eeBlockProfile* b) {
+			const u64 ca = a->Cost(), cb = b->Cost();
+			return ca != cb ? ca > cb : a->hits > b->hits;
+		});
+
+		log_cb(RETRO_LOG_INFO, "EE block profile: %zu blocks, %llu hits, sampled 1/%llu\n",
+			sorted.size(), (unsigned long long)totalHits, (unsigned long long)SampleRate);
+		log_cb(RETRO_LOG_INFO, "  startpc     cost%%          hits  ticks/hit  insts  x86size  compiles  interpreted\n");
+
+		count = std::min<uint>(count, sorted.size());
+		for (uint i = 0; i < count; i++)
+		{
+			const eeBlockProfile& prof = *sorted[i];
+			std::string interp;
+			for (const char* name : prof.interpOps)
+			{
+				if (!interp.empty())
+					interp += ' ';
+				interp += name;
+			}
+			log_cb(RETRO_LOG_INFO, "  %08x  %6.2f  %12llu  %9llu  %5u  %7u  %8u  %s\n",
+				prof.startpc,
+				totalCost ? prof.Cost() * 100.0 / totalCost : 0.0,
+				(unsigned long long)prof.hits,
+				(unsigned long long)(prof.samples ? prof.ticks / prof.samples : 0),
+				prof.size, prof.x86size, prof.compiles, interp.c_str());
+		}
+	}
+};
+
+namespace EE {
+	extern eeBlockProfiler BlockProfiler;
+}
@@ -0,0 +1,711 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PrecompiledHeader.h"
+#include "Common.h"
+#include "System.h"
+#include "vtlb.h"
+#include "RecBlockCache.h"
+
+#include <wx/ffile.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <link.h>
+#endif
+
+// Bump the version whenever the recompilers change what a block depends on.
+static const u32 CacheMagic = 0x4b4c4252; // "RBLK"
+static const u32 CacheVersion = 2;
+static const size_t MaxCacheBytes = _1mb * 128;
+
+struct CacheFileHeader
+{
+	u32 magic;
+	u32 version;
+	u32 crc;
+	u32 blockCount;
+	u64 hostId;      // the emulator binary the code was compiled by
+	u32 configHash;  // settings that change the generated code
+	u32 pad;
+};
+
+static __fi size_t Align8(size_t size) { return (size + 7) & ~(size_t)7; }
+
+static u64 Fnv64(const void* data, size_t size)
+{
+	u64 hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ ((const u8*)data)[i]) * 1099511628211ull;
+	return hash;
+}
+
+// --------------------------------------------------------------------------------------
+//  Host image
+// --------------------------------------------------------------------------------------
+// The address range of the binary the emulator runs from, and an id that changes with it.
+// Code restored into a different binary would call into the wrong places.
+
+struct HostImage
+{
+	uptr base;
+	uptr end;
+	u64 id;
+	bool valid;
+};
+
+#if defined(__linux__)
+static int FindHostImage(struct dl_phdr_info* info, size_t, void* data)
+{
+	HostImage& image = *(HostImage*)data;
+	const uptr anchor = (uptr)&FindHostImage;
+
+	uptr lo = ~(uptr)0, hi = 0;
+	bool found = false;
+	for (int i = 0; i < info->dlpi_phnum; i++)
+	{
+		const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+		if (ph.p_type != PT_LOAD)
+			continue;
+
+		const uptr start = info->dlpi_addr + ph.p_vaddr;
+		lo = std::min(lo, start);
+		hi = std::max(hi, start + ph.p_memsz);
+		found |= anchor >= start && anchor < start + ph.p_memsz;
+	}
+
+	if (!found)
+		return 0;
+
+	image.base = lo;
+	image.end = hi;
+	image.id = 0;
+
+	// the GNU build id if there is one, a hash of the code otherwise
+	for (int i = 0; i < info->dlpi_phnum && !image.id; i++)
+	{
+		const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+		if (ph.p_type != PT_NOTE)
+			continue;
+
+		const u8* note = (const u8*)(info->dlpi_addr + ph.p_vaddr);
+		const u8* notesEnd = note + ph.p_memsz;
+		while (note + sizeof(ElfW(Nhdr)) <= notesEnd)
+		{
+			const ElfW(Nhdr)* hdr = (const ElfW(Nhdr)*)note;
+			const u8* name = note + sizeof(ElfW(Nhdr));
+			const u8* desc = name + ((hdr->n_namesz + 3) & ~3u); // padded to 4 bytes
+			if (hdr->n_type == NT_GNU_BUILD_ID && hdr->n_namesz == 4 && !memcmp(name, "GNU", 4))
+			{
+				image.id = Fnv64(desc, hdr->n_descsz);
+				break;
+			}
+			note = desc + ((hdr->n_descsz + 3) & ~3u);
+		}
+	}
+
+	for (int i = 0; i < info->dlpi_phnum && !image.id; i++)
+	{
+		const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+		if (ph.p_type != PT_LOAD || !(ph.p_flags & PF_X))
+			continue;
+
+		image.id = Fnv64((const void*)(info->dlpi_addr + ph.p_vaddr), ph.p_filesz);
+	}
+
+	image.valid = image.id != 0;
+	return 1;
+}
+#endif
+
+static const HostImage& GetHostImage()
+{
+	static HostImage image = {};
+	static bool searched = false;
+
+	if (searched)
+		return image;
+	searched = true;
+
+#if defined(_WIN32)
+	HMODULE module;
+	if (GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+			(LPCWSTR)&GetHostImage, &module))
+	{
+		const IMAGE_DOS_HEADER* dos = (const IMAGE_DOS_HEADER*)module;
+		const IMAGE_NT_HEADERS* nt = (const IMAGE_NT_HEADERS*)((const u8*)module + dos->e_lfanew);
+		image.base = (uptr)module;
+		image.end = image.base + nt->OptionalHeader.SizeOfImage;
+		image.id = ((u64)nt->FileHeader.TimeDateStamp << 32) | nt->OptionalHeader.SizeOfImage;
+		image.valid = true;
+	}
+#elif defined(__linux__)
+	dl_iterate_phdr(FindHostImage, &image);
+#endif
+
+	return image;
+}
+
+static u32 GetConfigHash()
+{
+	const u32 values[] = {
+		EmuConfig.bitset,
+		EmuConfig.Cpu.Recompiler.bitset,
+		EmuConfig.Cpu.sseMXCSR.bitmask,
+		EmuConfig.Cpu.sseVUMXCSR.bitmask,
+		EmuConfig.Speedhacks.bitset,
+		(u32)EmuConfig.Speedhacks.EECycleRate,
+		EmuConfig.Speedhacks.EECycleSkip,
+		EmuConfig.Gamefixes.bitset,
+		x86caps.Flags, x86caps.Flags2, x86caps.EFlags, x86caps.EFlags2, x86caps.SEFlag,
+	};
+
+	u32 hash = 2166136261u;
+	for (u32 value : values)
+		hash = (hash ^ value) * 16777619u;
+	return hash;
+}
+
+static uptr GetMemoryBase()
+{
+	return (uptr)GetVmMemory().MainMemory()->GetBase();
+}
+
+// --------------------------------------------------------------------------------------
+//  Records
+// --------------------------------------------------------------------------------------
+// A record is a Block followed by its variable parts, see RecBlockCache::Block.
+
+static const u32* GuestCode(const RecBlockCache::Block& block)
+{
+	return (const u32*)(&block + 1);
+}
+
+static const u8* HostCode(const RecBlockCache::Block& block)
+{
+	return (const u8*)GuestCode(block) + Align8(block.range * 4);
+}
+
+static const RecBlockCache::Reloc* Relocs(const RecBlockCache::Block& block)
+{
+	return (const RecBlockCache::Reloc*)(HostCode(block) + Align8(block.codeSize));
+}
+
+static const RecBlockCache::Mapping* Mappings(const RecBlockCache::Block& block)
+{
+	return (const RecBlockCache::Mapping*)(Relocs(block) + block.relocCount);
+}
+
+static const RecBlockCache::FastmemSite* FastmemSites(const RecBlockCache::Block& block)
+{
+	return (const RecBlockCache::FastmemSite*)(Mappings(block) + block.mappingCount);
+}
+
+size_t RecBlockCache::RecordSize(const Block& block)
+{
+	return sizeof(Block) + Align8(block.range * 4) + Align8(block.codeSize) + block.relocCount * sizeof(Reloc)
+		+ block.mappingCount * sizeof(Mapping) + block.fastmemCount * sizeof(FastmemSite);
+}
+
+// What vtlb page vpage maps to, in a form that doesn't depend on where memory was allocated:
+// handlers keep their id and physical address, memory becomes an offset into the main memory
+// reservation.  valid is cleared for memory outside of it.
+u64 RecBlockCache::MappingKey(u32 vpage, bool& valid)
+{
+	using namespace vtlb_private;
+
+	const sptr entry = (sptr)(vtlbdata.vmap[vpage].raw() + ((uptr)vpage << VTLB_PAGE_BITS));
+	valid = true;
+	if (entry < 0)
+		return (u64)entry;
+
+	const uptr base = GetMemoryBase();
+	valid = (uptr)entry >= base && (uptr)entry < base + HostMemoryMap::Size;
+	return (u64)((uptr)entry - base);
+}
+
+// --------------------------------------------------------------------------------------
+//  RecBlockCache
+// --------------------------------------------------------------------------------------
+
+RecBlockCache::RecBlockCache(const char* name)
+	: m_name(name)
+	, m_crc(0)
+	, m_constBase(0)
+	, m_constSize(0)
+	, m_constAlloc(NULL)
+	, m_bytes(0)
+	, m_dirty(false)
+	, m_code(NULL)
+	, m_restored(0)
+	, m_stale(0)
+	, m_uncached(0)
+{
+	m_tableBase[0] = m_tableBase[1] = 0;
+	m_tableSize[0] = m_tableSize[1] = 0;
+}
+
+void RecBlockCache::SetTable(int index, const void* base, size_t size)
+{
+	m_tableBase[index] = (uptr)base;
+	m_tableSize[index] = base ? size : 0;
+}
+
+void RecBlockCache::SetConstBuffer(const u32* base, size_t size, ConstAllocFn* alloc)
+{
+	m_constBase = (uptr)base;
+	m_constSize = size;
+	m_constAlloc = alloc;
+}
+
+wxString RecBlockCache::GetFilename(u32 crc) const
+{
+	return wxFileName(EmuConfig.RecCacheFolder.GetPath(), wxsFormat(L"%s_%08X.bin", fromUTF8(m_name).c_str(), crc)).GetFullPath();
+}
+
+void RecBlockCache::Open(u32 crc)
+{
+	if (crc == m_crc)
+		return;
+
+	Close();
+	if (!crc || !EmuConfig.RecCacheFolder.IsOk())
+		return;
+
+	// Addresses below 4GB can be emitted as plain 32 bit immediates, which aren't logged.
+	const HostImage& image = GetHostImage();
+	const uptr low = (uptr)1 << 32;
+	if (!image.valid || image.base < low || GetMemoryBase() < low || (m_constBase && m_constBase < low)
+		|| (m_tableBase[0] && m_tableBase[0] < low) || (m_tableBase[1] && m_tableBase[1] < low))
+	{
+		static bool warned = false;
+		if (!warned)
+			log_cb(RETRO_LOG_WARN, "%s block cache: not supported by this build, recompiled code won't be kept\n", m_name);
+		warned = true;
+		return;
+	}
+
+	m_crc = crc;
+	Load();
+}
+
+void RecBlockCache::Close()
+{
+	CancelBlock();
+
+	if (!m_crc)
+		return;
+
+	Save();
+
+	if (m_restored || m_stale || m_uncached)
+		log_cb(RETRO_LOG_INFO, "%s block cache %08X: %u blocks restored, %u dropped as changed, %u not cacheable\n",
+			m_name, m_crc, m_restored, m_stale, m_uncached);
+
+	m_blocks.clear();
+	m_bytes = 0;
+	m_dirty = false;
+	m_restored = m_stale = m_uncached = 0;
+	m_crc = 0;
+}
+
+void RecBlockCache::Load()
+{
+	const wxString filename = GetFilename(m_crc);
+	if (!wxFileExists(filename))
+		return;
+
+	wxFFile fp(filename, L"rb");
+	if (!fp.IsOpened())
+		return;
+
+	CacheFileHeader header;
+	if (fp.Read(&header, sizeof(header)) != sizeof(header) || header.magic != CacheMagic
+		|| header.version != CacheVersion || header.crc != m_crc
+		|| header.hostId != GetHostImage().id || header.configHash != GetConfigHash())
+	{
+		log_cb(RETRO_LOG_WARN, "%s block cache %08X: ignoring cache file of another build or settings\n", m_name, m_crc);
+		return;
+	}
+
+	const size_t length = (size_t)fp.Length() - sizeof(header);
+	if (length > MaxCacheBytes)
+		return;
+
+	std::vector<u8> data(length);
+	if (length && fp.Read(data.data(), length) != length)
+		return;
+
+	size_t pos = 0;
+	for (u32 i = 0; i < header.blockCount; i++)
+	{
+		if (pos + sizeof(Block) > length)
+			break;
+
+		const Block& block = *(const Block*)&data[pos];
+		const size_t size = RecordSize(block);
+		if (pos + size > length || !block.size || block.range < block.size || block.codeSize > _64kb)
+		{
+			log_cb(RETRO_LOG_WARN, "%s block cache %08X: cache file is truncated, discarding it\n", m_name, m_crc);
+			m_blocks.clear();
+			m_bytes = 0;
+			return;
+		}
+
+		m_blocks[block.startpc].assign(&data[pos], &data[pos] + size);
+		m_bytes += size;
+		pos += size;
+	}
+
+	log_cb(RETRO_LOG_INFO, "%s block cache %08X: loaded %u blocks (%u KB)\n",
+		m_name, m_crc, (u32)m_blocks.size(), (u32)(m_bytes / _1kb));
+}
+
+void RecBlockCache::Save()
+{
+	if (!m_dirty)
+		return;
+
+	wxFileName folder(EmuConfig.RecCacheFolder);
+	if (!folder.DirExists() && !folder.Mkdir(0777, wxPATH_MKDIR_FULL))
+		return;
+
+	const wxString filename = GetFilename(m_crc);
+	wxFFile fp(filename, L"wb");
+	if (!fp.IsOpened())
+	{
+		log_cb(RETRO_LOG_WARN, "%s block cache %08X: cannot write %s\n", m_name, m_crc, filename.ToUTF8().data());
+		return;
+	}
+
+	CacheFileHeader header = {CacheMagic, CacheVersion, m_crc, (u32)m_blocks.size(), GetHostImage().id, GetConfigHash(), 0};
+	bool ok = fp.Write(&header, sizeof(header)) == sizeof(header);
+
+	for (const auto& block : m_blocks)
+		ok = ok && fp.Write(block.second.data(), block.second.size()) == block.second.size();
+
+	if (!ok)
+	{
+		// a partial file would only be rejected on the next load
+		fp.Close();
+		wxRemoveFile(filename);
+	}
+}
+
+// Finds what target points into, see RelocBase.
+bool RecBlockCache::Classify(uptr target, u8& base, u64& offset, u8& slot) const
+{
+	slot = 0;
+
+	if (m_constBase && target >= m_constBase && target < m_constBase + m_constSize)
+	{
+		base = Base_Const;
+		slot = (target - m_constBase) & 7;
+		offset = *(const u64*)(target & ~(uptr)7);
+		return true;
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		if (target >= m_tableBase[i] && target < m_tableBase[i] + m_tableSize[i])
+		{
+			base = Base_Table0 + i;
+			offset = target - m_tableBase[i];
+			return true;
+		}
+	}
+
+	const HostImage& image = GetHostImage();
+	if (target >= image.base && target < image.end)
+	{
+		base = Base_Image;
+		offset = target - image.base;
+		return true;
+	}
+
+	// the code caches are left out, nothing but links may point into them
+	const uptr memory = GetMemoryBase();
+	if (target >= memory && target < memory + HostMemoryMap::Size
+		&& (target < memory + HostMemoryMap::EErecOffset || target >= memory + HostMemoryMap::bumpAllocatorOffset))
+	{
+		base = Base_Memory;
+		offset = target - memory;
+		return true;
+	}
+
+	return false;
+}
+
+uptr RecBlockCache::BaseAddress(u8 base) const
+{
+	switch (base)
+	{
+		case Base_Image:  return GetHostImage().base;
+		case Base_Memory: return GetMemoryBase();
+		case Base_Table0: return m_tableBase[0];
+		case Base_Table1: return m_tableBase[1];
+	}
+	return 0;
+}
+
+void RecBlockCache::BeginBlock(u8* code, bool trackPages)
+{
+	CancelBlock();
+	if (!m_crc)
+		return;
+
+	m_code = code;
+	xRelocLog = &m_sites;
+	if (trackPages)
+		vtlb_DynGenTrackConstPages(&m_pages);
+}
+
+void RecBlockCache::NoteLink(u32 pc, s32* jumpptr)
+{
+	if (m_code)
+		m_links.push_back(std::make_pair(pc, jumpptr));
+}
+
+void RecBlockCache::CancelBlock()
+{
+	if (xRelocLog == &m_sites)
+		xRelocLog = NULL;
+	vtlb_DynGenTrackConstPages(NULL);
+
+	m_code = NULL;
+	m_sites.clear();
+	m_links.clear();
+	m_pages.clear();
+}
+
+void RecBlockCache::EndBlock(u32 startpc, u32 paddr, u32 size, u32 range, u32 flags, const u32* guest, u8* end)
+{
+	u8* code = m_code;
+	if (!code || !guest || !size || range < size || range > 0xffff)
+	{
+		CancelBlock();
+		return;
+	}
+
+	xRelocLog = NULL;
+	vtlb_DynGenTrackConstPages(NULL);
+
+	const u32 codeSize = end - code;
+	bool cacheable = codeSize <= _64kb;
+
+	std::vector<Reloc> relocs;
+	for (const xRelocSite& site : m_sites)
+	{
+		// anything emitted somewhere else meanwhile isn't part of the block
+		if (site.site < code || site.site >= end || !cacheable)
+			continue;
+
+		Reloc reloc = {(u32)(site.site - code), site.type, 0, site.extra, 0, 0};
+		uptr target;
+
+		switch (site.type)
+		{
+			case xReloc_Rel8:
+				// short jumps have to stay inside the block
+				target = (uptr)site.site + 1 + *(s8*)site.site;
+				cacheable = target >= (uptr)code && target < (uptr)end;
+				continue;
+
+			case xReloc_Rel32:
+			{
+				auto link = std::find_if(m_links.begin(), m_links.end(),
+					[&](const std::pair<u32, s32*>& l) { return (u8*)l.second == site.site; });
+				if (link != m_links.end())
+				{
+					reloc.base = Base_Link;
+					reloc.target = link->first;
+					relocs.push_back(reloc);
+					continue;
+				}
+
+				target = (uptr)site.site + 4 + site.extra + *(s32*)site.site;
+				if (target >= (uptr)code && target < (uptr)end)
+					continue;
+				break;
+			}
+
+			case xReloc_Abs64:
+				target = *(uptr*)site.site;
+				if (target >= (uptr)code && target < (uptr)end)
+				{
+					reloc.base = Base_Code;
+					reloc.target = target - (uptr)code;
+					relocs.push_back(reloc);
+					continue;
+				}
+				break;
+
+			default:
+				cacheable = false;
+				continue;
+		}
+
+		cacheable = Classify(target, reloc.base, reloc.target, reloc.slot);
+		relocs.push_back(reloc);
+	}
+
+	std::vector<Mapping> mappings;
+	std::sort(m_pages.begin(), m_pages.end());
+	m_pages.erase(std::unique(m_pages.begin(), m_pages.end()), m_pages.end());
+	for (u32 vpage : m_pages)
+	{
+		bool valid;
+		mappings.push_back({vpage, 0, MappingKey(vpage, valid)});
+		cacheable &= valid;
+	}
+
+	std::vector<vtlb_FastmemSite> sites;
+	std::vector<FastmemSite> fastmem;
+	vtlb_DynGenFastmemGetSites((uptr)code, (uptr)end, sites);
+	for (const vtlb_FastmemSite& site : sites)
+	{
+		cacheable &= site.start >= (uptr)code && site.start < (uptr)end && site.stub >= (uptr)code && site.stub < (uptr)end;
+		fastmem.push_back({(u32)(site.access - (uptr)code), (u32)(site.start - (uptr)code), (u32)(site.stub - (uptr)code)});
+	}
+
+	CancelBlock();
+
+	if (!cacheable || relocs.size() > 0xffff || mappings.size() > 0xffff || fastmem.size() > 0xffff)
+	{
+		m_uncached++;
+		return;
+	}
+
+	Block block = {startpc, paddr, (u16)size, (u16)flags, codeSize, (u16)relocs.size(), (u16)mappings.size(), (u16)fastmem.size(), (u16)range};
+	const size_t recordSize = RecordSize(block);
+
+	auto old = m_blocks.find(startpc);
+	const size_t oldSize = old != m_blocks.end() ? old->second.size() : 0;
+	if (m_bytes - oldSize + recordSize > MaxCacheBytes)
+		return;
+
+	std::vector<u8> record(recordSize);
+	memcpy(&record[0], &block, sizeof(block));
+	Block& copy = *(Block*)&record[0];
+	memcpy((void*)GuestCode(copy), guest, range * 4);
+	memcpy((void*)HostCode(copy), code, codeSize);
+	if (!relocs.empty())
+		memcpy((void*)Relocs(copy), relocs.data(), relocs.size() * sizeof(Reloc));
+	if (!mappings.empty())
+		memcpy((void*)Mappings(copy), mappings.data(), mappings.size() * sizeof(Mapping));
+	if (!fastmem.empty())
+		memcpy((void*)FastmemSites(copy), fastmem.data(), fastmem.size() * sizeof(FastmemSite));
+
+	m_bytes += recordSize - oldSize;
+	m_blocks[startpc] = std::move(record);
+	m_dirty = true;
+}
+
+const RecBlockCache::Block* RecBlockCache::Find(u32 startpc, u32 paddr, const u32* guest)
+{
+	if (!m_crc || !guest)
+		return NULL;
+
+	auto it = m_blocks.find(startpc);
+	if (it == m_blocks.end())
+		return NULL;
+
+	const Block& block = *(const Block*)it->second.data();
+	if (block.paddr != paddr)
+		return NULL;
+
+	// the recompiled block replaces the record
+	if (memcmp(GuestCode(block), guest, block.range * 4))
+	{
+		m_stale++;
+		return NULL;
+	}
+
+	const Mapping* mappings = Mappings(block);
+	for (u32 i = 0; i < block.mappingCount; i++)
+	{
+		bool valid;
+		if (MappingKey(mappings[i].vpage, valid) != mappings[i].key || !valid)
+			return NULL;
+	}
+
+	return &block;
+}
+
+bool RecBlockCache::Restore(const Block* block, u8* code)
+{
+	memcpy(code, HostCode(*block), block->codeSize);
+
+	const Reloc* relocs = Relocs(*block);
+	for (u32 i = 0; i < block->relocCount; i++)
+	{
+		const Reloc& reloc = relocs[i];
+		u8* field = code + reloc.offset;
+		uptr target;
+
+		switch (reloc.base)
+		{
+			case Base_Link:
+				continue;
+
+			case Base_Const:
+			{
+				u32* slot = m_constAlloc ? m_constAlloc((u32)(reloc.target >> 32), (u32)reloc.target) : NULL;
+				if (!slot)
+					return false;
+				target = (uptr)slot + reloc.slot;
+				break;
+			}
+
+			case Base_Code:
+				target = (uptr)code + reloc.target;
+				break;
+
+			default:
+				if (!BaseAddress(reloc.base))
+					return false;
+				target = BaseAddress(reloc.base) + reloc.target;
+				break;
+		}
+
+		if (reloc.type == xReloc_Abs64)
+			*(uptr*)field = target;
+		else
+		{
+			const sptr disp = (sptr)(target - ((uptr)field + 4 + reloc.extra));
+			if (disp != (s32)disp)
+				return false;
+			*(s32*)field = (s32)disp;
+		}
+	}
+
+	m_restored++;
+	return true;
+}
+
+void RecBlockCache::Link(const Block* block, u8* code, BaseBlocks& links)
+{
+	const Reloc* relocs = Relocs(*block);
+	for (u32 i = 0; i < block->relocCount; i++)
+	{
+		if (relocs[i].base == Base_Link)
+			links.Link((u32)relocs[i].target, (s32*)(code + relocs[i].offset));
+	}
+
+	const FastmemSite* fastmem = FastmemSites(*block);
+	for (u32 i = 0; i < block->fastmemCount; i++)
+		vtlb_DynGenFastmemAddSite({(uptr)code + fastmem[i].access, (uptr)code + fastmem[i].start, (uptr)code + fastmem[i].stub});
+}
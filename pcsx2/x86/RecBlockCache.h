@@ -0,0 +1,168 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "BaseblockEx.h"
+#include "x86emitter/x86emitter.h"
+
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------------------------------------
+//  RecBlockCache
+// --------------------------------------------------------------------------------------
+// Keeps the host code of the blocks a recompiler compiled for a game, in a file per game
+// keyed by the ELF CRC, so that later sessions copy a block into the code cache instead of
+// recompiling it.  Blocks are restored one at a time, when the dispatcher first reaches them.
+//
+// While a block is compiled the emitter logs every address and displacement it writes (see
+// xRelocLog).  Each one is stored relative to what it points into: the emulator image
+// (helpers, dispatchers, cpuRegs and the other static state), the main memory reservation,
+// the recompiler's tables (recLUT blocks, fastmem) or the constant buffer.  Jumps to other
+// blocks are stored by guest pc and relinked through BaseBlocks.  Blocks pointing anywhere
+// else are simply not cached.
+//
+// A block is only restored if its guest code is unchanged and the vtlb pages it resolved
+// at compile time still map the same way.  The file is tied to the emulator binary and to
+// the settings that change code generation, and is ignored when either differs.
+//
+class RecBlockCache
+{
+public:
+	enum BlockFlags
+	{
+		Block_Superblock = 1, // was compiled as an EE superblock
+		Block_Protected  = 2, // was compiled on a write protected page (has the SMC guard)
+	};
+
+	// What a relocated address is relative to
+	enum RelocBase
+	{
+		Base_Image,   // the emulator binary
+		Base_Memory,  // the main memory reservation, except the code caches
+		Base_Table0,  // see SetTable
+		Base_Table1,
+		Base_Const,   // a 64 bit constant of the constant buffer (target holds its value)
+		Base_Code,    // the block itself
+		Base_Link,    // the block starting at a guest address, linked with BaseBlocks
+		Base_Count
+	};
+
+	struct Block
+	{
+		u32 startpc;      // guest pc the block was compiled for
+		u32 paddr;        // physical address of startpc when it was compiled
+		u16 size;         // in instructions
+		u16 flags;        // BlockFlags
+		u32 codeSize;     // bytes of host code
+		u16 relocCount;
+		u16 mappingCount;
+		u16 fastmemCount;
+		u16 range;        // instructions of guest code the block depends on, at least size
+		// followed by that guest code, the host code (padded to 8 bytes), the Relocs, the
+		// Mappings and the FastmemSites
+	};
+
+	struct Reloc
+	{
+		u32 offset;       // of the field in the host code
+		u8 type;          // xRelocType
+		u8 base;          // RelocBase
+		u8 extra;         // see xRelocSite
+		u8 slot;          // Base_Const: byte offset into the constant
+		u64 target;       // offset from the base, or the constant, or the guest pc
+	};
+
+	struct Mapping
+	{
+		u32 vpage;        // vtlb page a _Const access was resolved through
+		u32 pad;
+		u64 key;          // see MappingKey
+	};
+
+	struct FastmemSite
+	{
+		u32 access;       // offsets into the host code, see vtlb_FastmemSite
+		u32 start;
+		u32 stub;
+	};
+
+	// Allocates a slot of the constant buffer holding the given value.
+	typedef u32* ConstAllocFn(u32 hi, u32 lo);
+
+	RecBlockCache(const char* name);
+
+	bool IsOpen() const { return m_crc != 0; }
+	u32 GetCrc() const { return m_crc; }
+
+	void SetTable(int index, const void* base, size_t size);
+	void SetConstBuffer(const u32* base, size_t size, ConstAllocFn* alloc);
+
+	// Loads the cache of the game with the given ELF CRC, saving the current one first.
+	// A CRC of 0 (the BIOS) just closes the cache.
+	void Open(u32 crc);
+	void Close();
+
+	// Starts logging the code emitted from code on.  trackPages also records the vtlb pages
+	// the _Const accesses resolve.
+	void BeginBlock(u8* code, bool trackPages);
+	void NoteLink(u32 pc, s32* jumpptr);
+	// Stores the block that was emitted in [code, end), if everything it points to can be
+	// relocated.  Also stops the logging.
+	void EndBlock(u32 startpc, u32 paddr, u32 size, u32 range, u32 flags, const u32* guest, u8* end);
+	void CancelBlock();
+
+	// Returns the record of startpc if it can be restored for paddr with the given guest code.
+	const Block* Find(u32 startpc, u32 paddr, const u32* guest);
+	// Copies the block to code, which has room for block->codeSize bytes, and fixes it up.
+	// Nothing is changed but code and the constant buffer if this fails.
+	bool Restore(const Block* block, u8* code);
+	// Links the restored block to the others, once links knows about it (BaseBlocks::New).
+	void Link(const Block* block, u8* code, BaseBlocks& links);
+
+protected:
+	static size_t RecordSize(const Block& block);
+	static u64 MappingKey(u32 vpage, bool& valid);
+
+	bool Classify(uptr target, u8& base, u64& offset, u8& slot) const;
+	uptr BaseAddress(u8 base) const;
+
+	wxString GetFilename(u32 crc) const;
+	void Load();
+	void Save();
+
+	const char* m_name;
+	u32 m_crc;
+
+	uptr m_tableBase[2];
+	size_t m_tableSize[2];
+	uptr m_constBase;
+	size_t m_constSize;
+	ConstAllocFn* m_constAlloc;
+
+	std::unordered_map<u32, std::vector<u8>> m_blocks; // records, by start pc
+	size_t m_bytes;
+	bool m_dirty;
+
+	u8* m_code;                                  // start of the block being logged
+	std::vector<xRelocSite> m_sites;
+	std::vector<std::pair<u32, s32*>> m_links;
+	std::vector<u32> m_pages;
+
+	u32 m_restored;      // blocks copied instead of recompiled
+	u32 m_stale;         // records dropped because their code changed
+	u32 m_uncached;      // blocks that pointed to something that can't be relocated
+};
@@ -26,6 +26,15 @@ using namespace x86Emitter;
 const __aligned16 u32 g_minvals[4]	= {0xff7fffff, 0xff7fffff, 0xff7fffff, 0xff7fffff};
 const __aligned16 u32 g_maxvals[4]	= {0x7f7fffff, 0x7f7fffff, 0x7f7fffff, 0x7f7fffff};
 
+u64 g_fpuClampedRegs = 0;
+bool g_fpuResultClamped = false;
+
+void recFPUClampedWrite(int xmminfo)
+{
+	if (xmminfo & XMMINFO_WRITED) FPU_SET_CLAMPED(_Sa_, g_fpuResultClamped); // Fd
+	if (xmminfo & XMMINFO_WRITEACC) FPU_SET_CLAMPED(XMMFPU_ACC, g_fpuResultClamped);
+}
+
 //------------------------------------------------------------------
 namespace R5900 {
 namespace Dynarec {
@@ -217,6 +226,8 @@ void recMFC1()
 //------------------------------------------------------------------
 void recMTC1()
 {
+	FPU_SET_CLAMPED(_Fs_, false);
+
 	if( GPR_IS_CONST1(_Rt_) )
 	{
 		_deleteFPtoXMMreg(_Fs_, 0);
@@ -353,9 +364,20 @@ __fi void fpuFloat3(int regd) {
 	else fpuFloat4(regd);
 }
 
+// Clamps the result of the instruction being compiled.
 void ClampValues(int regd) {
 	fpuFloat(regd);
+	g_fpuResultClamped = CHECK_FPU_OVERFLOW;
 }
+
+// Clamp elimination: once any of the clamps above has produced a value (so it is neither NaN
+// nor Inf, and not denormal when the EE's MXCSR has DAZ set) all of them leave it unchanged.
+// g_fpuClampedRegs tracks the registers known to hold such values in the block being compiled,
+// and operands loaded from them are not clamped again.  The results are the same as with
+// every clamp in place, only the redundant MINSS/MAXSS pairs are gone.
+__fi void fpuFloatFpr(int regd, int fpr) { if (!FPU_IS_CLAMPED(fpr)) fpuFloat(regd); }
+__fi void fpuFloat2Fpr(int regd, int fpr) { if (!FPU_IS_CLAMPED(fpr)) fpuFloat2(regd); }
+__fi void fpuFloat3Fpr(int regd, int fpr) { if (!FPU_IS_CLAMPED(fpr)) fpuFloat3(regd); }
 //------------------------------------------------------------------
 
 
@@ -370,8 +392,13 @@ void recABS_S_xmm(int info)
 	xAND.PS(xRegisterSSE(EEREC_D), ptr[&s_pos[0]]);
 	//xAND(ptr32[&fpuRegs.fprc[31]], ~(FPUflagO|FPUflagU)); // Clear O and U flags
 
-	if (CHECK_FPU_OVERFLOW) // Only need to do positive clamp, since EEREC_D is positive
+	if (FPU_IS_CLAMPED(_Fs_))
+		g_fpuResultClamped = true;
+	else if (CHECK_FPU_OVERFLOW) // Only need to do positive clamp, since EEREC_D is positive
+	{
 		xMIN.SS(xRegisterSSE(EEREC_D), ptr[&g_maxvals[0]]);
+		g_fpuResultClamped = true;
+	}
 }
 
 FPURECOMPILE_CONSTCODE(ABS_S, XMMINFO_WRITED|XMMINFO_READS);
@@ -544,35 +571,35 @@ int recCommutativeOp(int info, int regd, int op)
 		case PROCESS_EE_S:
 			if (regd == EEREC_S) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW  /*&& !CHECK_FPUCLAMPHACK */ || (op >= 2)) { fpuFloat2(regd); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW  /*&& !CHECK_FPUCLAMPHACK */ || (op >= 2)) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(t0reg, _Ft_); }
 				recComOpXMM_to_XMM[op](regd, t0reg);
 			}
 			else {
 				xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2(regd); fpuFloat2(EEREC_S); }
+				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(EEREC_S, _Fs_); }
 				recComOpXMM_to_XMM_REV[op](regd, EEREC_S);
 			}
 			break;
 		case PROCESS_EE_T:
 			if (regd == EEREC_T) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2(regd); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(t0reg, _Fs_); }
 				recComOpXMM_to_XMM_REV[op](regd, t0reg);
 			}
 			else {
 				xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Fs_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2(regd); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				recComOpXMM_to_XMM[op](regd, EEREC_T);
 			}
 			break;
 		case (PROCESS_EE_S|PROCESS_EE_T):
 			if (regd == EEREC_T) {
-				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2(regd); fpuFloat2(EEREC_S); }
+				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(EEREC_S, _Fs_); }
 				recComOpXMM_to_XMM_REV[op](regd, EEREC_S);
 			}
 			else {
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(EEREC_S));
-				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2(regd); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				recComOpXMM_to_XMM[op](regd, EEREC_T);
 			}
 			break;
@@ -580,11 +607,15 @@ int recCommutativeOp(int info, int regd, int op)
 			log_cb(RETRO_LOG_DEBUG, "FPU: recCommutativeOp case 4\n");
 			xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Fs_]]);
 			xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-			if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2(regd); fpuFloat2(t0reg); }
+			if (CHECK_FPU_EXTRA_OVERFLOW || (op >= 2)) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(t0reg, _Ft_); }
 			recComOpXMM_to_XMM[op](regd, t0reg);
 			break;
 	}
 
+	// MAX/MIN return one of their clamped operands
+	if (op >= 2)
+		g_fpuResultClamped = CHECK_FPU_OVERFLOW;
+
 	_freeXMMreg(t0reg);
 	return regd;
 }
@@ -666,30 +697,30 @@ void recC_EQ_xmm(int info)
 
 	switch(info & (PROCESS_EE_S|PROCESS_EE_T) ) {
 		case PROCESS_EE_S:
-			fpuFloat3(EEREC_S);
+			fpuFloat3Fpr(EEREC_S, _Fs_);
 			t0reg = _allocTempXMMreg(XMMT_FPS, -1);
 			if (t0reg >= 0) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				fpuFloat3(t0reg);
+				fpuFloat3Fpr(t0reg, _Ft_);
 				xUCOMI.SS(xRegisterSSE(EEREC_S), xRegisterSSE(t0reg));
 				_freeXMMreg(t0reg);
 			}
 			else xUCOMI.SS(xRegisterSSE(EEREC_S), ptr[&fpuRegs.fpr[_Ft_]]);
 			break;
 		case PROCESS_EE_T:
-			fpuFloat3(EEREC_T);
+			fpuFloat3Fpr(EEREC_T, _Ft_);
 			t0reg = _allocTempXMMreg(XMMT_FPS, -1);
 			if (t0reg >= 0) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
-				fpuFloat3(t0reg);
+				fpuFloat3Fpr(t0reg, _Fs_);
 				xUCOMI.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_T));
 				_freeXMMreg(t0reg);
 			}
 			else xUCOMI.SS(xRegisterSSE(EEREC_T), ptr[&fpuRegs.fpr[_Fs_]]);
 			break;
 		case (PROCESS_EE_S|PROCESS_EE_T):
-			fpuFloat3(EEREC_S);
-			fpuFloat3(EEREC_T);
+			fpuFloat3Fpr(EEREC_S, _Fs_);
+			fpuFloat3Fpr(EEREC_T, _Ft_);
 			xUCOMI.SS(xRegisterSSE(EEREC_S), xRegisterSSE(EEREC_T));
 			break;
 		default:
@@ -735,22 +766,22 @@ void recC_LE_xmm(int info )
 
 	switch(info & (PROCESS_EE_S|PROCESS_EE_T) ) {
 		case PROCESS_EE_S:
-			fpuFloat3(EEREC_S);
+			fpuFloat3Fpr(EEREC_S, _Fs_);
 			t0reg = _allocTempXMMreg(XMMT_FPS, -1);
 			if (t0reg >= 0) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				fpuFloat3(t0reg);
+				fpuFloat3Fpr(t0reg, _Ft_);
 				xUCOMI.SS(xRegisterSSE(EEREC_S), xRegisterSSE(t0reg));
 				_freeXMMreg(t0reg);
 			}
 			else xUCOMI.SS(xRegisterSSE(EEREC_S), ptr[&fpuRegs.fpr[_Ft_]]);
 			break;
 		case PROCESS_EE_T:
-			fpuFloat3(EEREC_T);
+			fpuFloat3Fpr(EEREC_T, _Ft_);
 			t0reg = _allocTempXMMreg(XMMT_FPS, -1);
 			if (t0reg >= 0) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
-				fpuFloat3(t0reg);
+				fpuFloat3Fpr(t0reg, _Fs_);
 				xUCOMI.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_T));
 				_freeXMMreg(t0reg);
 			}
@@ -767,8 +798,8 @@ void recC_LE_xmm(int info )
 			}
 			break;
 		case (PROCESS_EE_S|PROCESS_EE_T):
-			fpuFloat3(EEREC_S);
-			fpuFloat3(EEREC_T);
+			fpuFloat3Fpr(EEREC_S, _Fs_);
+			fpuFloat3Fpr(EEREC_T, _Ft_);
 			xUCOMI.SS(xRegisterSSE(EEREC_S), xRegisterSSE(EEREC_T));
 			break;
 		default: // Untested and incorrect, but this case is never reached AFAIK (cottonvibes)
@@ -808,22 +839,22 @@ void recC_LT_xmm(int info)
 
 	switch(info & (PROCESS_EE_S|PROCESS_EE_T) ) {
 		case PROCESS_EE_S:
-			fpuFloat3(EEREC_S);
+			fpuFloat3Fpr(EEREC_S, _Fs_);
 			t0reg = _allocTempXMMreg(XMMT_FPS, -1);
 			if (t0reg >= 0) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				fpuFloat3(t0reg);
+				fpuFloat3Fpr(t0reg, _Ft_);
 				xUCOMI.SS(xRegisterSSE(EEREC_S), xRegisterSSE(t0reg));
 				_freeXMMreg(t0reg);
 			}
 			else xUCOMI.SS(xRegisterSSE(EEREC_S), ptr[&fpuRegs.fpr[_Ft_]]);
 			break;
 		case PROCESS_EE_T:
-			fpuFloat3(EEREC_T);
+			fpuFloat3Fpr(EEREC_T, _Ft_);
 			t0reg = _allocTempXMMreg(XMMT_FPS, -1);
 			if (t0reg >= 0) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
-				fpuFloat3(t0reg);
+				fpuFloat3Fpr(t0reg, _Fs_);
 				xUCOMI.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_T));
 				_freeXMMreg(t0reg);
 			}
@@ -842,8 +873,8 @@ void recC_LT_xmm(int info)
 		case (PROCESS_EE_S|PROCESS_EE_T):
 			// Clamp NaNs
 			// Note: This fixes a crash in Rule of Rose.
-			fpuFloat3(EEREC_S);
-			fpuFloat3(EEREC_T);
+			fpuFloat3Fpr(EEREC_S, _Fs_);
+			fpuFloat3Fpr(EEREC_T, _Ft_);
 			xUCOMI.SS(xRegisterSSE(EEREC_S), xRegisterSSE(EEREC_T));
 			break;
 		default:
@@ -887,12 +918,16 @@ void recCVT_S_xmm(int info)
 	else {
 		xCVTDQ2PS(xRegisterSSE(EEREC_D), xRegisterSSE(EEREC_S));
 	}
+
+	g_fpuResultClamped = true; // integers convert to normal floats or zero
 }
 
 FPURECOMPILE_CONSTCODE(CVT_S, XMMINFO_WRITED|XMMINFO_READS);
 
 void recCVT_W()
 {
+	FPU_SET_CLAMPED(_Fd_, false);
+
 	if (CHECK_FPU_FULL)
 	{
 		DOUBLE::recCVT_W();
@@ -905,7 +940,7 @@ void recCVT_W()
 
 	if( regs >= 0 )
 	{
-		if (CHECK_FPU_EXTRA_OVERFLOW) fpuFloat2(regs);
+		if (CHECK_FPU_EXTRA_OVERFLOW) fpuFloat2Fpr(regs, _Fs_);
 		xCVTTSS2SI(eax, xRegisterSSE(regs));
 		xMOVMSKPS(edx, xRegisterSSE(regs));	//extract the signs
 		xAND(edx, 1);				//keep only LSB
@@ -972,7 +1007,7 @@ void recDIVhelper1(int regd, int regt) // Sets flags
 	x86SetJ32(ajmp32);
 
 	/*--- Normal Divide ---*/
-	if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(regt); }
+	if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(regt, _Ft_); }
 	xDIV.SS(xRegisterSSE(regd), xRegisterSSE(regt));
 
 	ClampValues(regd);
@@ -984,7 +1019,7 @@ void recDIVhelper1(int regd, int regt) // Sets flags
 
 void recDIVhelper2(int regd, int regt) // Doesn't sets flags
 {
-	if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(regt); }
+	if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(regt, _Ft_); }
 	xDIV.SS(xRegisterSSE(regd), xRegisterSSE(regt));
 	ClampValues(regd);
 }
@@ -1089,36 +1124,36 @@ void recMADDtemp(int info, int regd)
 		case PROCESS_EE_S:
 			if(regd == EEREC_S) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(t0reg, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 				if (info & PROCESS_EE_ACC) {
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloat(regd); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(EEREC_ACC, XMMFPU_ACC); fpuFloat(regd); }
 					FPU_ADD(regd, EEREC_ACC);
 				}
 				else {
 					xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]);
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloat(t0reg); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 					FPU_ADD(regd, t0reg);
 				}
 			}
 			else if (regd == EEREC_ACC){
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(EEREC_S); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(EEREC_S, _Fs_); fpuFloat2Fpr(t0reg, _Ft_); }
 				xMUL.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_S));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(regd, XMMFPU_ACC); fpuFloat(t0reg); }
 				FPU_ADD(regd, t0reg);
 			}
 			else {
 				xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_S); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(EEREC_S, _Fs_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_S));
 				if (info & PROCESS_EE_ACC) {
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloat(regd); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(EEREC_ACC, XMMFPU_ACC); fpuFloat(regd); }
 					FPU_ADD(regd, EEREC_ACC);
 				}
 				else {
 					xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]);
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloat(t0reg); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 					FPU_ADD(regd, t0reg);
 				}
 			}
@@ -1126,85 +1161,85 @@ void recMADDtemp(int info, int regd)
 		case PROCESS_EE_T:
 			if(regd == EEREC_T) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(t0reg, _Fs_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 				if (info & PROCESS_EE_ACC) {
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloat(regd); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(EEREC_ACC, XMMFPU_ACC); fpuFloat(regd); }
 					FPU_ADD(regd, EEREC_ACC);
 				}
 				else {
 					xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]);
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloat(t0reg); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 					FPU_ADD(regd, t0reg);
 				}
 			}
 			else if (regd == EEREC_ACC){
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(EEREC_T); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(EEREC_T, _Ft_); fpuFloat2Fpr(t0reg, _Fs_); }
 				xMUL.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_T));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(regd, XMMFPU_ACC); fpuFloat(t0reg); }
 				FPU_ADD(regd, t0reg);
 			}
 			else {
 				xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Fs_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_T));
 				if (info & PROCESS_EE_ACC) {
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloat(regd); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(EEREC_ACC, XMMFPU_ACC); fpuFloat(regd); }
 					FPU_ADD(regd, EEREC_ACC);
 				}
 				else {
 					xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]);
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloat(t0reg); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(EEREC_ACC); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 					FPU_ADD(regd, t0reg);
 				}
 			}
 			break;
 		case (PROCESS_EE_S|PROCESS_EE_T):
 			if(regd == EEREC_S) {
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_T));
 				if (info & PROCESS_EE_ACC) {
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(EEREC_ACC); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(EEREC_ACC, XMMFPU_ACC); }
 					FPU_ADD(regd, EEREC_ACC);
 				}
 				else {
 					xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]);
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 					FPU_ADD(regd, t0reg);
 				}
 			}
 			else if(regd == EEREC_T) {
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_S); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(EEREC_S, _Fs_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_S));
 				if (info & PROCESS_EE_ACC) {
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(EEREC_ACC); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(EEREC_ACC, XMMFPU_ACC); }
 					FPU_ADD(regd, EEREC_ACC);
 				}
 				else {
 					xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]);
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 					FPU_ADD(regd, t0reg);
 				}
 			}
 			else if(regd == EEREC_ACC) {
 				xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_S));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(t0reg); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(t0reg, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				xMUL.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_T));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(regd, XMMFPU_ACC); fpuFloat(t0reg); }
 				FPU_ADD(regd, t0reg);
 			}
 			else {
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(EEREC_S));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_T));
 				if (info & PROCESS_EE_ACC) {
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(EEREC_ACC); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(EEREC_ACC, XMMFPU_ACC); }
 					FPU_ADD(regd, EEREC_ACC);
 				}
 				else {
 					xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]);
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 					FPU_ADD(regd, t0reg);
 				}
 			}
@@ -1214,9 +1249,9 @@ void recMADDtemp(int info, int regd)
 				t1reg = _allocTempXMMreg(XMMT_FPS, -1);
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
 				xMOVSSZX(xRegisterSSE(t1reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(t0reg); fpuFloat2(t1reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(t0reg, _Fs_); fpuFloat2Fpr(t1reg, _Ft_); }
 				xMUL.SS(xRegisterSSE(t0reg), xRegisterSSE(t1reg));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(regd, XMMFPU_ACC); fpuFloat(t0reg); }
 				FPU_ADD(regd, t0reg);
 				_freeXMMreg(t1reg);
 			}
@@ -1224,15 +1259,15 @@ void recMADDtemp(int info, int regd)
 			{
 				xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Fs_]]);
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(t0reg, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 				if (info & PROCESS_EE_ACC) {
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(EEREC_ACC); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(EEREC_ACC, XMMFPU_ACC); }
 					FPU_ADD(regd, EEREC_ACC);
 				}
 				else {
 					xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]);
-					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+					if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 					FPU_ADD(regd, t0reg);
 				}
 			}
@@ -1289,6 +1324,8 @@ void recMOV_S_xmm(int info)
 {
 	if( info & PROCESS_EE_S ) xMOVSS(xRegisterSSE(EEREC_D), xRegisterSSE(EEREC_S));
 	else xMOVSSZX(xRegisterSSE(EEREC_D), ptr[&fpuRegs.fpr[_Fs_]]);
+
+	g_fpuResultClamped = FPU_IS_CLAMPED(_Fs_);
 }
 
 FPURECOMPILE_CONSTCODE(MOV_S, XMMINFO_WRITED|XMMINFO_READS);
@@ -1307,28 +1344,28 @@ int t1reg;
 		case PROCESS_EE_S:
 			if(regd == EEREC_S) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(t0reg, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 				if (info & PROCESS_EE_ACC) { xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_ACC)); }
 				else { xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]); }
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 				FPU_SUB(t0reg, regd);
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 			}
 			else if (regd == EEREC_ACC){
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(EEREC_S); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(EEREC_S, _Fs_); fpuFloat2Fpr(t0reg, _Ft_); }
 				xMUL.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_S));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(regd, XMMFPU_ACC); fpuFloat(t0reg); }
 				FPU_SUB(regd, t0reg);
 			}
 			else {
 				xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_S); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(EEREC_S, _Fs_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_S));
 				if (info & PROCESS_EE_ACC) { xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_ACC)); }
 				else { xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]); }
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 				FPU_SUB(t0reg, regd);
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 			}
@@ -1336,65 +1373,65 @@ int t1reg;
 		case PROCESS_EE_T:
 			if(regd == EEREC_T) {
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(t0reg, _Fs_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 				if (info & PROCESS_EE_ACC) { xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_ACC)); }
 				else { xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]); }
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 				FPU_SUB(t0reg, regd);
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 			}
 			else if (regd == EEREC_ACC){
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(EEREC_T); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(EEREC_T, _Ft_); fpuFloat2Fpr(t0reg, _Fs_); }
 				xMUL.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_T));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(regd, XMMFPU_ACC); fpuFloat(t0reg); }
 				FPU_SUB(regd, t0reg);
 			}
 			else {
 				xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Fs_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_T));
 				if (info & PROCESS_EE_ACC) { xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_ACC)); }
 				else { xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]); }
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 				FPU_SUB(t0reg, regd);
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 			}
 			break;
 		case (PROCESS_EE_S|PROCESS_EE_T):
 			if(regd == EEREC_S) {
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_T));
 				if (info & PROCESS_EE_ACC) { xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_ACC)); }
 				else { xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]); }
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 				FPU_SUB(t0reg, regd);
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 			}
 			else if(regd == EEREC_T) {
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_S); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Ft_); fpuFloat2Fpr(EEREC_S, _Fs_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_S));
 				if (info & PROCESS_EE_ACC) { xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_ACC)); }
 				else { xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]); }
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 				FPU_SUB(t0reg, regd);
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 			}
 			else if(regd == EEREC_ACC) {
 				xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_S));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(t0reg); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(t0reg, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				xMUL.SS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_T));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(regd, XMMFPU_ACC); fpuFloat(t0reg); }
 				FPU_SUB(regd, t0reg);
 			}
 			else {
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(EEREC_S));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(EEREC_T); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(EEREC_T, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(EEREC_T));
 				if (info & PROCESS_EE_ACC) { xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_ACC)); }
 				else { xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]); }
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 				FPU_SUB(t0reg, regd);
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 			}
@@ -1404,9 +1441,9 @@ int t1reg;
 				t1reg = _allocTempXMMreg(XMMT_FPS, -1);
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Fs_]]);
 				xMOVSSZX(xRegisterSSE(t1reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(t0reg); fpuFloat2(t1reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(t0reg, _Fs_); fpuFloat2Fpr(t1reg, _Ft_); }
 				xMUL.SS(xRegisterSSE(t0reg), xRegisterSSE(t1reg));
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloatFpr(regd, XMMFPU_ACC); fpuFloat(t0reg); }
 				FPU_SUB(regd, t0reg);
 				_freeXMMreg(t1reg);
 			}
@@ -1414,11 +1451,11 @@ int t1reg;
 			{
 				xMOVSSZX(xRegisterSSE(regd), ptr[&fpuRegs.fpr[_Fs_]]);
 				xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.fpr[_Ft_]]);
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2(regd); fpuFloat2(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(t0reg, _Ft_); }
 				xMUL.SS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 				if (info & PROCESS_EE_ACC)  { xMOVSS(xRegisterSSE(t0reg), xRegisterSSE(EEREC_ACC)); }
 				else { xMOVSSZX(xRegisterSSE(t0reg), ptr[&fpuRegs.ACC]); }
-				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloat(t0reg); }
+				if (CHECK_FPU_EXTRA_OVERFLOW) { fpuFloat(regd); fpuFloatFpr(t0reg, XMMFPU_ACC); }
 				FPU_SUB(t0reg, regd);
 				xMOVSS(xRegisterSSE(regd), xRegisterSSE(t0reg));
 			}
@@ -1478,7 +1515,11 @@ void recNEG_S_xmm(int info) {
 
 	//xAND(ptr32[&fpuRegs.fprc[31]], ~(FPUflagO|FPUflagU)); // Clear O and U flags
 	xXOR.PS(xRegisterSSE(EEREC_D), ptr[&s_neg[0]]);
-	ClampValues(EEREC_D);
+
+	if (FPU_IS_CLAMPED(_Fs_))
+		g_fpuResultClamped = true; // the clamp range is symmetric
+	else
+		ClampValues(EEREC_D);
 }
 
 FPURECOMPILE_CONSTCODE(NEG_S, XMMINFO_WRITED|XMMINFO_READS);
@@ -1490,7 +1531,7 @@ FPURECOMPILE_CONSTCODE(NEG_S, XMMINFO_WRITED|XMMINFO_READS);
 //------------------------------------------------------------------
 void recSUBhelper(int regd, int regt)
 {
-	if (CHECK_FPU_EXTRA_OVERFLOW /*&& !CHECK_FPUCLAMPHACK*/) { fpuFloat2(regd); fpuFloat2(regt); }
+	if (CHECK_FPU_EXTRA_OVERFLOW /*&& !CHECK_FPUCLAMPHACK*/) { fpuFloat2Fpr(regd, _Fs_); fpuFloat2Fpr(regt, _Ft_); }
 	FPU_SUB(regd, regt);
 }
 
@@ -1599,10 +1640,13 @@ void recSQRT_S_xmm(int info)
 	}
 	else xAND.PS(xRegisterSSE(EEREC_D), ptr[&s_pos[0]]); // Make EEREC_D Positive
 
-	if (CHECK_FPU_OVERFLOW) xMIN.SS(xRegisterSSE(EEREC_D), ptr[&g_maxvals[0]]);// Only need to do positive clamp, since EEREC_D is positive
+	if (CHECK_FPU_OVERFLOW && !FPU_IS_CLAMPED(_Ft_)) xMIN.SS(xRegisterSSE(EEREC_D), ptr[&g_maxvals[0]]);// Only need to do positive clamp, since EEREC_D is positive
 	xSQRT.SS(xRegisterSSE(EEREC_D), xRegisterSSE(EEREC_D));
 	if (CHECK_FPU_EXTRA_OVERFLOW) ClampValues(EEREC_D); // Shouldn't need to clamp again since SQRT of a number will always be smaller than the original number, doing it just incase :/
 
+	// the root of a finite, positive value is finite and normal (or zero)
+	g_fpuResultClamped = CHECK_FPU_OVERFLOW || FPU_IS_CLAMPED(_Ft_);
+
 	if (roundmodeFlag) xLDMXCSR (g_sseMXCSR);
 }
 
@@ -1656,8 +1700,9 @@ void recRSQRThelper1(int regd, int t0reg) // Preforms the RSQRT function when re
 	x86SetJ8(pjmp1);
 
 	if (CHECK_FPU_EXTRA_OVERFLOW) {
-		xMIN.SS(xRegisterSSE(t0reg), ptr[&g_maxvals[0]]); // Only need to do positive clamp, since t0reg is positive
-		fpuFloat2(regd);
+		if (!FPU_IS_CLAMPED(_Ft_))
+			xMIN.SS(xRegisterSSE(t0reg), ptr[&g_maxvals[0]]); // Only need to do positive clamp, since t0reg is positive
+		fpuFloat2Fpr(regd, _Fs_);
 	}
 
 	xSQRT.SS(xRegisterSSE(t0reg), xRegisterSSE(t0reg));
@@ -1674,8 +1719,9 @@ void recRSQRThelper2(int regd, int t0reg) // Preforms the RSQRT function when re
 {
 	xAND.PS(xRegisterSSE(t0reg), ptr[&s_pos[0]]); // Make t0reg Positive
 	if (CHECK_FPU_EXTRA_OVERFLOW) {
-		xMIN.SS(xRegisterSSE(t0reg), ptr[&g_maxvals[0]]); // Only need to do positive clamp, since t0reg is positive
-		fpuFloat2(regd);
+		if (!FPU_IS_CLAMPED(_Ft_))
+			xMIN.SS(xRegisterSSE(t0reg), ptr[&g_maxvals[0]]); // Only need to do positive clamp, since t0reg is positive
+		fpuFloat2Fpr(regd, _Fs_);
 	}
 	xSQRT.SS(xRegisterSSE(t0reg), xRegisterSSE(t0reg));
 	xDIV.SS(xRegisterSSE(regd), xRegisterSSE(t0reg));
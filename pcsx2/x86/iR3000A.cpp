@@ -22,9 +22,11 @@
 
 #include "iR3000A.h"
 #include "BaseblockEx.h"
+#include "RecBlockCache.h"
 #include "System/RecTypes.h"
 
 #include <time.h>
+#include <unordered_set>
 
 #ifndef _WIN32
 #include <sys/types.h>
@@ -34,6 +36,7 @@
 #include "iCore.h"
 
 #include "AppConfig.h"
+#include "Elfheader.h"
 
 using namespace x86Emitter;
 
@@ -66,10 +69,20 @@ static u32 s_nInstCacheSize = 0;
 static BASEBLOCK* s_pCurBlock = NULL;
 static BASEBLOCKEX* s_pCurBlockEx = NULL;
 
+// The host code of the blocks compiled in IOP RAM is kept per game, and copied back instead
+// of recompiled in later sessions (see RecBlockCache and recRestoreBlock).
+static RecBlockCache s_blockCache("IOP");
+
 static u32 s_nEndBlock = 0; // what psxpc the current block ends
 static u32 s_branchTo;
 static bool s_nBlockFF;
 
+// Wait loops (see iopRecRecompile) skip straight to the next IOP event.  The skipped cycles
+// are counted per title, keyed by the ELF CRC, and logged when the title changes.
+static std::unordered_set<u32> s_idleLoops;	// start pcs of the wait loops found so far
+static u64 s_idleCyclesSkipped;
+static u32 s_idleCrc;
+
 static u32 s_saveConstRegs[32];
 static u32 s_saveHasConstReg = 0, s_saveFlushedConstReg = 0;
 static EEINST* s_psaveInstInfo = NULL;
@@ -645,11 +658,22 @@ void recResetIOP()
 
 	recBlocks.Reset();
 	g_psxMaxRecMem = 0;
+	s_blockCache.CancelBlock();
 
 	recPtr = *recMem;
 	psxbranch = 0;
 }
 
+static void recReportIdleLoops()
+{
+	if (!s_idleLoops.empty())
+		log_cb(RETRO_LOG_INFO, "IOP/iR3000A idle loops for %08X: %u found, %llu cycles skipped (%.2f s of IOP time)\n",
+			s_idleCrc, (u32)s_idleLoops.size(), (unsigned long long)s_idleCyclesSkipped, (double)s_idleCyclesSkipped / PSXCLK);
+	s_idleLoops.clear();
+	s_idleCyclesSkipped = 0;
+	s_idleCrc = ElfCRC;
+}
+
 static void recShutdown()
 {
 	safe_delete( recMem );
@@ -658,6 +682,10 @@ static void recShutdown()
 
 	safe_free( s_pInstCache );
 	s_nInstCacheSize = 0;
+
+	s_blockCache.Close();
+
+	recReportIdleLoops();
 }
 
 static void iopClearRecLUT(BASEBLOCK* base, int count)
@@ -804,6 +832,13 @@ void psxSetBranchReg(u32 reg)
 	JMP32((uptr)iopDispatcherReg - ( (uptr)x86Ptr + 5 ));
 }
 
+// Links a jump to the block at pc (see BaseBlocks::Link), and notes it for the block cache.
+static void recLinkBlock(u32 pc, s32* jumpptr)
+{
+	s_blockCache.NoteLink(pc, jumpptr);
+	recBlocks.Link(pc, jumpptr);
+}
+
 void psxSetBranchImm( u32 imm )
 {
 	psxbranch = 1;
@@ -814,7 +849,7 @@ void psxSetBranchImm( u32 imm )
 	_psxFlushCall(FLUSH_EVERYTHING);
 	iPsxBranchTest(imm, imm <= psxpc);
 
-	recBlocks.Link(HWADDR(imm), xJcc32());
+	recLinkBlock(HWADDR(imm), xJcc32());
 }
 
 static __fi u32 psxScaleBlockCycles()
@@ -837,7 +872,15 @@ static void iPsxBranchTest(u32 newpc, u32 cpuBranch)
 		xCMP(eax, ptr32[&g_iopNextEventCycle]);
 		xCMOVNS(eax, ptr32[&g_iopNextEventCycle]);
 		xMOV(ptr32[&psxRegs.cycle], eax);
-		xSUB(eax, ecx);
+		xSUB(eax, ecx); // cycles advanced, negative if the event is due already
+
+		// Only what goes beyond the block's own cycles was actually skipped.
+		xMOV(edx, eax);
+		xSUB(edx, blockCycles);
+		xForwardJLE8 nothingSkipped;
+		xADD(ptrNative[&s_idleCyclesSkipped], rdx);
+		nothingSkipped.SetTarget();
+
 		xSHL(eax, 3);
 		xSUB(ptr32[&iopCycleEE], eax);
 		xJLE(iopExitRecompiledCode);
@@ -954,6 +997,69 @@ void psxRecompileNextInstruction(int delayslot)
 	_clearNeededX86regs();
 }
 
+// Blocks calling into the HLE BIOS depend on more than their guest code.
+static bool recBlockCacheable(u32 startpc)
+{
+	const u32 paddr = HWADDR(startpc);
+
+	return s_blockCache.IsOpen() && paddr < Ps2MemSize::IopRam
+		&& paddr != 0xa0 && paddr != 0xb0 && paddr != 0xc0;
+}
+
+// Copies startpc's block out of the block cache instead of compiling it, if it was compiled
+// for the same guest code and block boundaries.  recPtr is where the block goes, with room
+// for any block.
+static bool recRestoreBlock(u32 startpc)
+{
+	if (ElfCRC != s_blockCache.GetCrc() && EmuConfig.RecBlockCache)
+	{
+		s_blockCache.SetTable(0, m_recBlockAlloc, m_recBlockAllocSize);
+		s_blockCache.Open(ElfCRC);
+	}
+
+	if (!recBlockCacheable(startpc))
+		return false;
+
+	const u32 paddr = HWADDR(startpc);
+	const BASEBLOCKEX* existing = recBlocks.Get(paddr);
+	if (existing && existing->startpc == paddr)
+		return false;
+
+	const RecBlockCache::Block* block = s_blockCache.Find(startpc, paddr, iopVirtMemR<u32>(startpc));
+	if (!block)
+		return false;
+
+	// blocks end where another one starts
+	for (u32 i = 1; i < block->size; i++)
+	{
+		const uptr fnptr = PSX_GETBLOCK(startpc + i * 4)->GetFnptr();
+		if (fnptr != (uptr)iopJITCompile && fnptr != (uptr)iopJITCompileInBlock)
+			return false;
+	}
+
+	if (!s_blockCache.Restore(block, recPtr))
+		return false;
+
+	BASEBLOCK* pblock = PSX_GETBLOCK(startpc);
+	BASEBLOCKEX* blockEx = recBlocks.New(paddr, (uptr)recPtr);
+	blockEx->size = block->size;
+	blockEx->x86size = block->codeSize;
+	s_blockCache.Link(block, recPtr, recBlocks);
+
+	pblock->SetFnptr((uptr)recPtr);
+	for (u32 i = 1; i < block->size; ++i) {
+		if (pblock[i].GetFnptr() == (uptr)iopJITCompile)
+			pblock[i].SetFnptr((uptr)iopJITCompileInBlock);
+	}
+
+	const u32 endpc = startpc + block->size * 4;
+	if( !(endpc&0x10000000) )
+		g_psxMaxRecMem = std::max( (endpc&~0xa0000000), g_psxMaxRecMem );
+
+	recPtr += block->codeSize;
+	return true;
+}
+
 static void __fastcall iopRecRecompile( const u32 startpc )
 {
 	u32 i;
@@ -969,6 +1075,9 @@ static void __fastcall iopRecRecompile( const u32 startpc )
 
 	pxAssert( startpc );
 
+	if (ElfCRC != s_idleCrc)
+		recReportIdleLoops();
+
 	// if recPtr reached the mem limit reset whole mem
 	if (recPtr >= (recMem->GetPtrEnd() - _64kb)) {
 		recResetIOP();
@@ -978,6 +1087,12 @@ static void __fastcall iopRecRecompile( const u32 startpc )
 	x86Align(16);
 	recPtr = x86Ptr;
 
+	if (recRestoreBlock(startpc))
+		return;
+
+	if (recBlockCacheable(startpc))
+		s_blockCache.BeginBlock(recPtr, false);
+
 	s_pCurBlock = PSX_GETBLOCK(startpc);
 
 	pxAssert(s_pCurBlock->GetFnptr() == (uptr)iopJITCompile
@@ -1066,19 +1181,73 @@ static void __fastcall iopRecRecompile( const u32 startpc )
 
 StartRecomp:
 
+	// Wait loops: as long as a loop doesn't write to a register it has already read (apart
+	// from registers set from memory or COP0 loads) and doesn't change any other machine state,
+	// every iteration does the same thing until an event changes what it loads.  This covers
+	// the kernel's idle loop and modules polling a hardware register or a flag in memory,
+	// see the analogous check in the EE recompiler.
 	s_nBlockFF = false;
 	if (s_branchTo == startpc) {
 		s_nBlockFF = true;
+
+		u32 reads = 0, loads = 1;
+
 		for (i = startpc; i < s_nEndBlock; i += 4) {
-			if (i != s_nEndBlock - 8) {
-				switch (iopMemRead32(i)) {
-					case 0: // nop
-						break;
-					default:
-						s_nBlockFF = false;
-				}
+			if (i == s_nEndBlock - 8)
+				continue;
+			psxRegs.code = iopMemRead32(i);
+			const u32 op = psxRegs.code >> 26;
+			u32 sources, dest;
+
+			// nop
+			if (psxRegs.code == 0)
+				continue;
+			// imm arithmetic and loads (LB..LWR)
+			else if ((op & 070) == 010 || ((op & 070) == 040 && op != 047))
+			{
+				sources = 1 << _Rs_;
+				dest = _Rt_;
+			}
+			// shifts by an immediate or by a register (SLL..SRAV)
+			else if (op == 0 && (_Funct_ & 070) == 0 && (_Funct_ & 3) != 1)
+			{
+				sources = 1 << _Rt_;
+				if (_Funct_ & 4)
+					sources |= 1 << _Rs_;
+				dest = _Rd_;
+			}
+			// register arithmetic (ADD..NOR, SLT, SLTU)
+			else if (op == 0 && ((_Funct_ & 070) == 040 || (_Funct_ & 076) == 052))
+			{
+				sources = 1 << _Rs_ | 1 << _Rt_;
+				dest = _Rd_;
+			}
+			// mfc0
+			else if (op == 020 && _Rs_ == 0)
+			{
+				loads |= 1 << _Rt_;
+				continue;
+			}
+			else
+			{
+				s_nBlockFF = false;
+				break;
+			}
+
+			if ((loads & sources) == sources) {
+				loads |= 1 << dest;
+				continue;
+			}
+			reads |= sources;
+			if (reads & 1 << dest) {
+				s_nBlockFF = false;
+				break;
 			}
 		}
+
+		if (s_nBlockFF && EmuConfig.Speedhacks.WaitLoop && s_idleLoops.insert(startpc).second)
+			log_cb(RETRO_LOG_INFO, "IOP/iR3000A idle loop at 0x%08x (%u instructions)\n",
+				startpc, (s_nEndBlock - startpc) / 4);
 	}
 
 	// rec info //
@@ -1139,7 +1308,7 @@ StartRecomp:
 			pxAssert( psxpc == s_nEndBlock );
 			_psxFlushCall(FLUSH_EVERYTHING);
 			xMOV(ptr32[&psxRegs.pc], psxpc);
-			recBlocks.Link(HWADDR(s_nEndBlock), xJcc32() );
+			recLinkBlock(HWADDR(s_nEndBlock), xJcc32() );
 			psxbranch = 3;
 		}
 	}
@@ -1153,6 +1322,9 @@ StartRecomp:
 
 	pxAssert( (g_psxHasConstReg&g_psxFlushedConstReg) == g_psxHasConstReg );
 
+	s_blockCache.EndBlock(startpc, HWADDR(startpc), s_pCurBlockEx->size, (s_nEndBlock-startpc) >> 2, 0,
+		iopVirtMemR<u32>(startpc), recPtr);
+
 	s_pCurBlock = NULL;
 	s_pCurBlockEx = NULL;
 }
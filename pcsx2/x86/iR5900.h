@@ -68,8 +68,10 @@ void SaveBranchState();
 void LoadBranchState();
 
 void recompileNextInstruction(int delayslot);
-void SetBranchReg( u32 reg );
+void SetBranchReg( u32 reg, bool isReturn = false );
 void SetBranchImm( u32 imm );
+void SetBranchImmOrContinue( u32 imm );
+void recPushReturnAddress( u32 retpc );
 
 void iFlushCall(int flushtype);
 void recBranchCall( void (*func)() );
@@ -210,13 +212,26 @@ void eeRecompileCodeConstSPECIAL(R5900FNPTR constcode, R5900FNPTR_INFO multicode
 #define XMMINFO_READACC		0x200
 #define XMMINFO_WRITEACC	0x400
 
+// FPU clamp tracking (see iFPU.cpp).  Bit n of g_fpuClampedRegs is set while FPR n (bit
+// XMMFPU_ACC: the ACC) is known to hold a value that every clamp function leaves unchanged,
+// so clamping it again can be skipped.  Handlers set g_fpuResultClamped when the value they
+// write qualifies; recFPUClampedWrite then updates the bit of the register written.
+extern u64 g_fpuClampedRegs;
+extern bool g_fpuResultClamped;
+#define FPU_IS_CLAMPED(fpr) ((g_fpuClampedRegs >> (fpr)) & 1)
+#define FPU_SET_CLAMPED(fpr, clamped) \
+	(g_fpuClampedRegs = (g_fpuClampedRegs & ~(1ull << (fpr))) | ((u64)(clamped) << (fpr)))
+void recFPUClampedWrite(int xmminfo);
+
 #define FPURECOMPILE_CONSTCODE(fn, xmminfo) \
 void rec##fn(void) \
 { \
+	g_fpuResultClamped = false; \
 	if (CHECK_FPU_FULL) \
 		eeFPURecompileCode(DOUBLE::rec##fn##_xmm, R5900::Interpreter::OpcodeImpl::COP1::fn, xmminfo); \
 	else \
 		eeFPURecompileCode(rec##fn##_xmm, R5900::Interpreter::OpcodeImpl::COP1::fn, xmminfo); \
+	recFPUClampedWrite(xmminfo); \
 }
 
 // rd = rs op rt (all regs need to be in xmm)
@@ -22,6 +22,7 @@
 #include "R5900OpcodeTables.h"
 #include "iR5900.h"
 #include "BaseblockEx.h"
+#include "RecBlockCache.h"
 #include "System/RecTypes.h"
 
 #include "vtlb.h"
@@ -41,6 +42,8 @@
 
 #include "Utilities/MemsetFast.inl"
 
+#include <unordered_set>
+
 
 using namespace x86Emitter;
 using namespace R5900;
@@ -69,12 +72,20 @@ bool g_cpuFlushedPC, g_cpuFlushedCode, g_recompilingDelaySlot, g_maySignalExcept
 static const int RECCONSTBUF_SIZE = 16384 * 2; // 64 bit consts in 32 bit units
 
 static RecompiledCodeReserve* recMem = NULL;
-static u8* recRAMCopy = NULL;
+static u32* recRAMCopy = NULL;
 static u8* recLutReserve_RAM = NULL;
 static const size_t recLutSize = (Ps2MemSize::MainRam + Ps2MemSize::Rom + Ps2MemSize::Rom1 + Ps2MemSize::Rom2) * wordsize / 4;
 
 static uptr m_ConfiguredCacheReserve = 64;
 
+// The code cache is split into regions that are filled in turn.  Once the last one is full
+// the oldest region is emptied and reused, so only the blocks compiled longest ago have to
+// be recompiled, instead of every block at once.
+static const int RecCacheRegions = 8;
+static int s_recCacheRegion = 0;
+static u32 s_recFullResets = 0;
+static u32 s_recPartialEvictions = 0;
+
 static u32* recConstBuf = NULL;			// 64-bit pseudo-immediates
 static BASEBLOCK *recRAM = NULL;		// and the ptr to the blocks here
 static BASEBLOCK *recROM = NULL;		// and here
@@ -89,18 +100,65 @@ static u32 s_nInstCacheSize = 0;
 
 static BASEBLOCK* s_pCurBlock = NULL;
 static BASEBLOCKEX* s_pCurBlockEx = NULL;
+
+namespace EE {
+	eeBlockProfiler BlockProfiler;
+}
+
+static void __fastcall recProfileBlock(eeBlockProfile* prof)
+{
+	EE::BlockProfiler.Enter(prof);
+}
 u32 s_nEndBlock = 0; // what pc the current block ends
 u32 s_branchTo;
 static bool s_nBlockFF;
 
+// Idle loops (blocks that branch back to themselves without changing machine state, see
+// StartRecomp) skip straight to the next event.  The skipped cycles are counted so the
+// savings can be read from the log.
+static std::unordered_set<u32> s_idleLoops;	// start pcs of the idle loops found so far
+static u64 s_idleCyclesSkipped;
+
+// The host code of the blocks compiled in RAM is kept per game, and copied back instead of
+// recompiled in later sessions (see RecBlockCache and recRestoreBlock).
+static RecBlockCache s_blockCache("EE");
+
+// Superblocks: blocks entered SuperblockThreshold times are recompiled so that they run
+// through unconditional jumps and the not-taken side of forward branches, keeping constants
+// and cached registers live across them.  Taken branches become side exits.  The merged code
+// stays inside one 4k page so the usual page protection and recClear ranges still cover it.
+static const u32 SuperblockThreshold = 512;
+static const u32 SuperblockCounterCount = 16384; // counters are shared by hashed start pc
+static const int SuperblockMaxEntries = 8;       // branches merged into one superblock
+
+static __aligned16 u32 s_superblockCounters[SuperblockCounterCount];
+static std::unordered_set<u32> s_superblockHot;  // HWADDR of promoted block starts
+static bool s_nSuperblock;                       // the current block is a superblock
+static u32 s_superblockEntries[SuperblockMaxEntries]; // pcs where compilation continues
+static int s_superblockEntryCount;
+
+// Return address prediction: JAL and JALR push the return address, with the LUT slot of the
+// block starting there, on a small ring.  JR $ra pops the top entry and, if it holds the
+// address being returned to, jumps through the slot straight from the returning block.  This
+// skips the dispatcher, and gives each return its own indirect jump for the host to predict.
+// LUT slots never move once recAlloc has set them up, so entries survive block clears.
+static const u32 ReturnStackSize = 16;
+
+static __aligned16 u32 s_returnStackPc[ReturnStackSize];
+static uptr s_returnStackSlot[ReturnStackSize];
+static u32 s_returnStackTop;
+
 // save states for branches
 GPR_reg64 s_saveConstRegs[32];
 static u32 s_saveHasConstReg = 0, s_saveFlushedConstReg = 0;
+static u64 s_saveFpuClampedRegs = 0;
 static EEINST* s_psaveInstInfo = NULL;
 
 static u32 s_savenBlockCycles = 0;
 
 static void iBranchTest(u32 newpc = 0xffffffff);
+static void iBranchTestReturn();
+static void recLinkBlock(u32 pc, s32* jumpptr);
 static void ClearRecLUT(BASEBLOCK* base, int count);
 static u32 scaleblockcycles();
 
@@ -297,6 +355,9 @@ void recBranchCall( void (*func)() )
 
 void recCall( void (*func)() )
 {
+	if (EE::BlockProfiler.current)
+		EE::BlockProfiler.EmitInterpOp(GetCurrentInstruction().Name);
+
 	iFlushCall(FLUSH_INTERPRETER);
 	xFastCall((void*)func);
 }
@@ -496,7 +557,7 @@ static void recAlloc()
 {
 	if (!recRAMCopy)
 	{
-		recRAMCopy = (u8*)_aligned_malloc(Ps2MemSize::MainRam, 4096);
+		recRAMCopy = (u32*)_aligned_malloc(Ps2MemSize::MainRam, 4096);
 	}
 
 	if (!recRAM)
@@ -568,6 +629,17 @@ static void recAlloc()
 
 static __aligned16 u16 manual_page[Ps2MemSize::MainRam >> 12];
 static __aligned16 u8 manual_counter[Ps2MemSize::MainRam >> 12];
+static __aligned16 u32 manual_lines[Ps2MemSize::MainRam >> 12]; // SMC lines of manual blocks
+
+// Blocks invalidated by writes into protected pages, and the ones left alone because the
+// write missed their lines.
+static u32 s_smcBlocksCleared = 0;
+static u32 s_smcBlocksSpared = 0;
+
+// Blocks on write protected pages jump here from their entry once the page isn't protected
+// anymore (see memory_protect_recompiled_code); the code check is emitted after the block.
+static s32* s_smcGuardJump = NULL;
+static u8* s_smcGuardResume = NULL;
 
 static std::atomic<bool> eeRecIsReset(false);
 static std::atomic<bool> eeRecNeedsReset(false);
@@ -583,9 +655,12 @@ static void recResetRaw()
 	if( eeRecIsReset.exchange(true) ) return;
 	eeRecNeedsReset = false;
 
-	log_cb(RETRO_LOG_INFO, "EE/iR5900-32 Recompiler Reset\n" );
+	s_recFullResets++;
+	log_cb(RETRO_LOG_INFO, "EE/iR5900-32 Recompiler Reset (full resets: %u, partial evictions: %u)\n",
+		s_recFullResets, s_recPartialEvictions);
 
 	recMem->Reset();
+	vtlb_DynGenFastmemClear((uptr)recMem->GetPtr(), (uptr)recMem->GetPtrEnd());
 	ClearRecLUT((BASEBLOCK*)recLutReserve_RAM, recLutSize);
 	memset(recRAMCopy, 0, Ps2MemSize::MainRam);
 
@@ -598,10 +673,21 @@ static void recResetRaw()
 
 	recBlocks.Reset();
 	mmap_ResetBlockTracking();
+	memzero(manual_lines);
+
+	std::fill(std::begin(s_superblockCounters), std::end(s_superblockCounters), SuperblockThreshold);
+	s_superblockHot.clear();
+	s_blockCache.CancelBlock();
+
+	// No valid return address is odd, so these never match.
+	std::fill(std::begin(s_returnStackPc), std::end(s_returnStackPc), 1);
+	memzero(s_returnStackSlot);
+	s_returnStackTop = 0;
 
 	x86SetPtr(*recMem);
 
 	recPtr = *recMem;
+	s_recCacheRegion = 0;
 	recConstBufPtr = recConstBuf;
 
 	g_branch = 0;
@@ -609,6 +695,34 @@ static void recResetRaw()
 	g_patchesNeedRedo = 1;
 }
 
+static u8* recCacheRegionStart(int region)
+{
+	return recMem->GetPtr() + recMem->GetReserveSizeInBytes() / RecCacheRegions * region;
+}
+
+// Moves code allocation on to the next cache region, evicting the blocks still in it.
+static void recEvictCacheRegion()
+{
+	s_recCacheRegion = (s_recCacheRegion + 1) % RecCacheRegions;
+
+	u8* start = recCacheRegionStart(s_recCacheRegion);
+	u8* end = recCacheRegionStart(s_recCacheRegion + 1);
+
+	int evicted = recBlocks.RemoveCode((uptr)start, (uptr)end, [](const BASEBLOCKEX& block) {
+		PC_GETBLOCK(block.startpc)->SetFnptr((uptr)JITCompile);
+	});
+	vtlb_DynGenFastmemClear((uptr)start, (uptr)end);
+
+	if (evicted)
+	{
+		s_recPartialEvictions++;
+		log_cb(RETRO_LOG_DEBUG, "EE/iR5900-32 Recompiler evicted %d blocks (full resets: %u, partial evictions: %u)\n",
+			evicted, s_recFullResets, s_recPartialEvictions);
+	}
+
+	recPtr = start;
+}
+
 static void recShutdown()
 {
 	safe_delete( recMem );
@@ -617,6 +731,23 @@ static void recShutdown()
 
 	recBlocks.Reset();
 
+	if (EmuConfig.EEBlockProfiler)
+		EE::BlockProfiler.Print();
+	EE::BlockProfiler.Reset();
+	s_superblockHot.clear();
+	s_blockCache.Close();
+
+	if (s_smcBlocksCleared || s_smcBlocksSpared)
+		log_cb(RETRO_LOG_INFO, "EE/iR5900-32 SMC: %u blocks invalidated, %u spared by line tracking\n",
+			s_smcBlocksCleared, s_smcBlocksSpared);
+	s_smcBlocksCleared = s_smcBlocksSpared = 0;
+
+	if (!s_idleLoops.empty())
+		log_cb(RETRO_LOG_INFO, "EE/iR5900-32 idle loops: %u found, %llu cycles skipped (%.2f s of EE time)\n",
+			(u32)s_idleLoops.size(), (unsigned long long)s_idleCyclesSkipped, (double)s_idleCyclesSkipped / PS2CLK);
+	s_idleLoops.clear();
+	s_idleCyclesSkipped = 0;
+
 	recRAM = recROM = recROM1 = recROM2 = NULL;
 
 	safe_aligned_free( recConstBuf );
@@ -676,6 +807,8 @@ static void recExecute()
 	// Implementation Notes:
 	// [TODO] fix this comment to explain various code entry/exit points, when I'm not so tired!
 
+	EE::BlockProfiler.CancelSample();
+
 #if PCSX2_SEH
 	eeRecIsReset   = false;
 	eeCpuExecuting = true;
@@ -824,7 +957,7 @@ void recClear(u32 addr, u32 size)
 
 static int *s_pCode;
 
-void SetBranchReg( u32 reg )
+void SetBranchReg( u32 reg, bool isReturn )
 {
 	g_branch = 1;
 
@@ -871,7 +1004,27 @@ void SetBranchReg( u32 reg )
 
 	iFlushCall(FLUSH_EVERYTHING);
 
-	iBranchTest();
+	if (isReturn && !EmuConfig.Gamefixes.GoemonTlbHack)
+		iBranchTestReturn();
+	else
+		iBranchTest();
+}
+
+// Pushes retpc on the return stack.  Emitted at the end of a call's block, once everything
+// has been flushed.
+void recPushReturnAddress( u32 retpc )
+{
+	if (EmuConfig.Gamefixes.GoemonTlbHack)
+		return;
+
+	xMOV(eax, ptr32[&s_returnStackTop]);
+	xADD(eax, 1);
+	xAND(eax, ReturnStackSize - 1);
+	xMOV(ptr32[&s_returnStackTop], eax);
+
+	xMOV(ptr32[xComplexAddress(rcx, s_returnStackPc, rax*4)], retpc);
+	xLoadFarAddr(rdx, PC_GETBLOCK(retpc));
+	xMOV(ptrNative[xComplexAddress(rcx, s_returnStackSlot, rax*wordsize)], rdx);
 }
 
 void SetBranchImm( u32 imm )
@@ -886,12 +1039,34 @@ void SetBranchImm( u32 imm )
 	iBranchTest(imm);
 }
 
+// Like SetBranchImm, unless imm is a place where the superblock being compiled continues:
+// then compilation simply carries on there with the current register and constant state.
+// Only valid for the last path a branch handler emits, since the continuation follows it.
+void SetBranchImmOrContinue( u32 imm )
+{
+	u32* entriesEnd = s_superblockEntries + s_superblockEntryCount;
+
+	if (s_nSuperblock && imm >= pc && imm < s_nEndBlock
+		&& std::find(s_superblockEntries, entriesEnd, imm) != entriesEnd)
+	{
+		// skip the instruction info of anything jumped over
+		g_pCurInstInfo += (imm - pc) / 4;
+		pc = imm;
+		// the taken path of a conditional branch already ended with SetBranchImm
+		g_branch = 0;
+		return;
+	}
+
+	SetBranchImm(imm);
+}
+
 void SaveBranchState()
 {
 	s_savenBlockCycles = s_nBlockCycles;
 	memcpy(s_saveConstRegs, g_cpuConstRegs, sizeof(g_cpuConstRegs));
 	s_saveHasConstReg = g_cpuHasConstReg;
 	s_saveFlushedConstReg = g_cpuFlushedConstReg;
+	s_saveFpuClampedRegs = g_fpuClampedRegs;
 	s_psaveInstInfo = g_pCurInstInfo;
 
 	memcpy(s_saveXMMregs, xmmregs, sizeof(xmmregs));
@@ -904,6 +1079,7 @@ void LoadBranchState()
 	memcpy(g_cpuConstRegs, s_saveConstRegs, sizeof(g_cpuConstRegs));
 	g_cpuHasConstReg = s_saveHasConstReg;
 	g_cpuFlushedConstReg = s_saveFlushedConstReg;
+	g_fpuClampedRegs = s_saveFpuClampedRegs;
 	g_pCurInstInfo = s_psaveInstInfo;
 
 	memcpy(xmmregs, s_saveXMMregs, sizeof(xmmregs));
@@ -1049,10 +1225,15 @@ static void iBranchTest(u32 newpc)
 	{
 		xMOV(eax, ptr32[&g_nextEventCycle]);
 		xADD(ptr32[&cpuRegs.cycle], scaleblockcycles());
-		xCMP(eax, ptr32[&cpuRegs.cycle]);
+		xMOV(edx, eax);
+		xSUB(edx, ptr32[&cpuRegs.cycle]); // cycles skipped, negative if the event is due already
 		xCMOVS(eax, ptr32[&cpuRegs.cycle]);
 		xMOV(ptr32[&cpuRegs.cycle], eax);
 
+		xForwardJS8 eventDue;
+		xADD(ptrNative[&s_idleCyclesSkipped], rdx);
+		eventDue.SetTarget();
+
 		xJMP( (void*)DispatcherEvent );
 	}
 	else
@@ -1065,12 +1246,36 @@ static void iBranchTest(u32 newpc)
 		if (newpc == 0xffffffff)
 			xJS( DispatcherReg );
 		else
-			recBlocks.Link(HWADDR(newpc), xJcc32(Jcc_Signed));
+			recLinkBlock(HWADDR(newpc), xJcc32(Jcc_Signed));
 
 		xJMP( (void*)DispatcherEvent );
 	}
 }
 
+// iBranchTest for JR $ra: pops the return stack and, if the top entry is cpuRegs.pc, jumps
+// through its LUT slot instead of going through DispatcherReg.
+static void iBranchTestReturn()
+{
+	// pop first, so that returns leaving through the event test keep the stack in step
+	xMOV(eax, ptr32[&s_returnStackTop]);
+	xLEA(edx, ptr[rax - 1]);
+	xAND(edx, ReturnStackSize - 1);
+	xMOV(ptr32[&s_returnStackTop], edx);
+
+	xMOV(edx, ptr[&cpuRegs.cycle]);
+	xADD(edx, scaleblockcycles());
+	xMOV(ptr[&cpuRegs.cycle], edx); // update cycles
+	xSUB(edx, ptr[&g_nextEventCycle]);
+	xJNS( (void*)DispatcherEvent );
+
+	xMOV(edx, ptr32[&cpuRegs.pc]);
+	xCMP(edx, ptr32[xComplexAddress(rcx, s_returnStackPc, rax*4)]);
+	xJNE( (void*)DispatcherReg );
+
+	xMOV(rcx, ptrNative[xComplexAddress(rcx, s_returnStackSlot, rax*wordsize)]);
+	xJMP(ptrNative[rcx]);
+}
+
 #ifdef PCSX2_DEVBUILD
 // opcode 'code' modifies:
 // 1: status
@@ -1480,27 +1685,137 @@ void __fastcall dyna_block_discard(u32 start,u32 sz)
 	recClear(start, sz);
 }
 
+static u32 recSmcLineMask(u32 addr, u32 bytes)
+{
+	u32 first = (addr & 0xfff) >> SmcLineShift;
+	u32 last = ((addr & 0xfff) + bytes - 1) >> SmcLineShift;
+
+	return (u32)(((2ull << last) - 1) & ~((1ull << first) - 1));
+}
+
+static u32 recCountPageBlocks(u32 page)
+{
+	u32 count = 0;
+
+	for (int i = recBlocks.LastIndex(page + 0xffc); BASEBLOCKEX* block = recBlocks[i]; i--) {
+		if (block->startpc < page)
+			break;
+		if (block->startpc <= page + 0xffc)
+			count++;
+	}
+
+	return count;
+}
+
+// Clears the blocks of the given SMC lines of a page and accounts for the others.
+static void recClearSmcLines(u32 page, u32 lines)
+{
+	u32 before = recCountPageBlocks(page);
+
+	for (u32 line = 0; lines; lines >>= 1, line++) {
+		if (lines & 1)
+			recClear(page + (line << SmcLineShift), SmcLineSize / 4);
+	}
+
+	u32 after = recCountPageBlocks(page);
+	s_smcBlocksCleared += before - after;
+	s_smcBlocksSpared += after;
+}
+
+// Called by the page fault handler when a write to a protected page unprotected it.  Only
+// the blocks of the written line have to go; the others check their code on entry while
+// the page stays unprotected.
+void recSmcPageWrite(u32 paddr, bool hasCode)
+{
+	recClearSmcLines(paddr & ~0xfff, hasCode ? 1u << ((paddr & 0xfff) >> SmcLineShift) : 0);
+}
+
 // called when a page under manual protection has been run enough times to be a candidate
-// for being reset under the faster vtlb write protection.  All blocks in the page are cleared
-// and the block is re-assigned for write protection.
+// for being reset under the faster vtlb write protection.  The counted manual blocks are
+// cleared (to get rid of their checks) and the page is re-assigned for write protection.
+// Blocks from before the page lost its protection are kept unless their code changed in the
+// meantime, since they stop checking it once the page is protected again.
 void __fastcall dyna_page_reset(u32 start,u32 sz)
 {
-	recClear(start & ~0xfffUL, 0x400);
+	u32 page = start & ~0xfffUL;
+	u32 lines = manual_lines[page >> 12];
+
+	for (int i = recBlocks.LastIndex(page + 0xffc); BASEBLOCKEX* block = recBlocks[i]; i--) {
+		if (block->startpc < page)
+			break;
+		if (block->startpc <= page + 0xffc &&
+			memcmp(&recRAMCopy[block->startpc / 4], PSM(block->startpc), block->size * 4))
+			lines |= recSmcLineMask(block->startpc, std::max<u32>(block->size, 1) * 4);
+	}
+
+	recClearSmcLines(page, lines);
+	manual_lines[page >> 12] = 0;
 	manual_counter[start >> 12]++;
 	mmap_MarkCountedRamPage( start );
 }
 
-static void memory_protect_recompiled_code(u32 startpc, u32 size)
+// The kernel context register is stored @ 0x800010C0-0x80001300
+// The EENULL thread context register is stored @ 0x81000-....
+static bool recContainsThreadStack(u32 startpc)
+{
+	return ((startpc >> 12) == 0x81) || ((startpc >> 12) == 0x80001);
+}
+
+// How the code of a block starting at startpc gets protected.
+static vtlb_ProtectionMode recGetProtection(u32 startpc)
+{
+	// note: blocks are guaranteed to reside within the confines of a single page.
+	return recContainsThreadStack(startpc) ? ProtMode_Manual : mmap_GetRamPageInfo( HWADDR(startpc) );
+}
+
+// Superblocks are not formed on manually protected pages (every instruction of the block
+// is compared on entry there) or when the Goemon TLB hack rewrites jump targets.
+static bool recSuperblockEligible(u32 startpc)
+{
+	if (!EmuConfig.EESuperblocks || EmuConfig.Gamefixes.GoemonTlbHack)
+		return false;
+
+	return recGetProtection(startpc) != ProtMode_Manual;
+}
+
+// Called from the tier-up counter of a block that got hot.  The block is cleared but keeps
+// running; the next time its start is dispatched it gets recompiled as a superblock.
+static void __fastcall recPromoteBlock(u32 startpc)
+{
+	s_superblockCounters[(HWADDR(startpc) >> 2) & (SuperblockCounterCount - 1)] = SuperblockThreshold;
+	s_superblockHot.insert(HWADDR(startpc));
+	recClear(startpc, 1);
+}
+
+// Superblock scan: records target as a place where compilation carries on after the branch
+// at branchpc.  Only forward targets within the page are followed.
+static bool recSuperblockFollow(u32 startpc, u32 branchpc, u32 target)
+{
+	if (!s_nSuperblock || s_superblockEntryCount >= SuperblockMaxEntries)
+		return false;
+
+	if (target < branchpc + 8 || (target & ~0xfffu) != (startpc & ~0xfffu))
+		return false;
+
+	s_superblockEntries[s_superblockEntryCount++] = target;
+	return true;
+}
+
+// Write protects the page of a block on a page that isn't under manual protection.
+static void recProtectBlockPage(u32 inpage_ptr, u32 inpage_sz)
+{
+	mmap_MarkCountedRamPage( inpage_ptr );
+	mmap_MarkCodeLines( inpage_ptr, inpage_sz );
+	manual_page[inpage_ptr >> 12] = 0;
+}
+
+static vtlb_ProtectionMode memory_protect_recompiled_code(u32 startpc, u32 size)
 {
 	u32 inpage_ptr = HWADDR(startpc);
 	u32 inpage_sz  = size*4;
 
-	// The kernel context register is stored @ 0x800010C0-0x80001300
-	// The EENULL thread context register is stored @ 0x81000-....
-	bool contains_thread_stack = ((startpc >> 12) == 0x81) || ((startpc >> 12) == 0x80001);
-
-	// note: blocks are guaranteed to reside within the confines of a single page.
-	const vtlb_ProtectionMode PageType = contains_thread_stack ? ProtMode_Manual : mmap_GetRamPageInfo( inpage_ptr );
+	bool contains_thread_stack = recContainsThreadStack(startpc);
+	const vtlb_ProtectionMode PageType = recGetProtection(startpc);
 
     switch (PageType)
     {
@@ -1509,11 +1824,20 @@ static void memory_protect_recompiled_code(u32 startpc, u32 size)
 
 		case ProtMode_None:
         case ProtMode_Write:
-			mmap_MarkCountedRamPage( inpage_ptr );
-			manual_page[inpage_ptr >> 12] = 0;
+			recProtectBlockPage( inpage_ptr, inpage_sz );
+
+			// A write elsewhere in the page can unprotect it without clearing this block, which
+			// then has to check its code like a manual block; see recEmitSmcGuardCheck.
+			xCMP( ptr32[mmap_GetRamPageModePtr( inpage_ptr )], ProtMode_Write );
+			s_smcGuardJump = xJcc32( Jcc_NotEqual );
+			s_smcGuardResume = xGetPtr();
 			break;
 
         case ProtMode_Manual:
+			// cleared when the page gets protected again, see dyna_page_reset
+			if (!contains_thread_stack)
+				manual_lines[inpage_ptr >> 12] |= recSmcLineMask(inpage_ptr, inpage_sz);
+
 			xMOV( arg1regd, inpage_ptr );
 			xMOV( arg2regd, inpage_sz / 4 );
 			//xMOV( eax, startpc );		// uncomment this to access startpc (as eax) in dyna_block_discard
@@ -1563,6 +1887,34 @@ static void memory_protect_recompiled_code(u32 startpc, u32 size)
 			}
             break;
 	}
+
+	return PageType;
+}
+
+// Emits the out of line code check of a block on a write protected page, which is run while
+// a write to some other line of the page has unprotected it.
+static void recEmitSmcGuardCheck(u32 startpc, u32 size)
+{
+	if (!s_smcGuardJump)
+		return;
+
+	u32 inpage_ptr = HWADDR(startpc);
+
+	*s_smcGuardJump = (s32)(xGetPtr() - (u8*)(s_smcGuardJump + 1));
+
+	xMOV( arg1regd, inpage_ptr );
+	xMOV( arg2regd, size );
+
+	for (u32 lpc = inpage_ptr; lpc < inpage_ptr + size * 4; lpc += 4)
+	{
+		xCMP( ptr32[PSM(lpc)], *(u32*)PSM(lpc) );
+		xJNE(DispatchBlockDiscard);
+	}
+
+	xJMP( s_smcGuardResume );
+
+	s_smcGuardJump = NULL;
+	s_smcGuardResume = NULL;
 }
 
 // Skip MPEG Game-Fix
@@ -1599,6 +1951,149 @@ void doPlace0Patches()
     ApplyLoadedPatches(PPT_ONCE_ON_LOAD);
 }
 
+// Links a jump to the block at pc (see BaseBlocks::Link), and notes it for the block cache.
+static void recLinkBlock(u32 pc, s32* jumpptr)
+{
+	s_blockCache.NoteLink(pc, jumpptr);
+	recBlocks.Link(pc, jumpptr);
+}
+
+// Constants of restored blocks; refuses once the buffer is about to be full, since running
+// out of it resets the recompiler.
+static u32* recBlockCacheConst(u32 hi, u32 lo)
+{
+	if ((recConstBufPtr - recConstBuf) >= RECCONSTBUF_SIZE - 64)
+		return NULL;
+
+	return recGetImm64(hi, lo);
+}
+
+// Blocks whose code depends on more than their guest code: the hooks of the boot process,
+// and everything while the debugger, the profiler or the Goemon TLB hack are in use.
+static bool recBlockCacheable(u32 startpc)
+{
+	const u32 paddr = HWADDR(startpc);
+
+	if (!s_blockCache.IsOpen() || paddr >= Ps2MemSize::MainRam)
+		return false;
+
+	if (EmuConfig.EEBlockProfiler || EmuConfig.Gamefixes.GoemonTlbHack
+		|| CBreakPoints::GetNumMemchecks() || !CBreakPoints::GetBreakpoints().empty())
+		return false;
+
+	return paddr != EELOAD_START && paddr != ElfEntry
+		&& !(g_eeloadMain && paddr == HWADDR(g_eeloadMain)) && !(g_eeloadExec && paddr == HWADDR(g_eeloadExec));
+}
+
+// Makes the block of s_pCurBlock/s_pCurBlockEx, ending at endpc, the one that runs for its
+// start, once its code is at recPtr.
+static void recCommitBlock(u32 startpc, u32 endpc)
+{
+	if (HWADDR(endpc) <= Ps2MemSize::MainRam) {
+		BASEBLOCKEX *oldBlock;
+		int i;
+
+		i = recBlocks.LastIndex(HWADDR(endpc) - 4);
+		while (oldBlock = recBlocks[i--]) {
+			if (oldBlock == s_pCurBlockEx)
+				continue;
+			if (oldBlock->startpc >= HWADDR(endpc))
+				continue;
+			if ((oldBlock->startpc + oldBlock->size * 4) <= HWADDR(startpc))
+				break;
+
+			if (memcmp(&recRAMCopy[oldBlock->startpc / 4], PSM(oldBlock->startpc),
+			           oldBlock->size * 4))
+			{
+				recClear(startpc, (endpc - startpc) / 4);
+				s_pCurBlockEx = recBlocks.Get(HWADDR(startpc));
+				pxAssert(s_pCurBlockEx->startpc == HWADDR(startpc));
+				break;
+			}
+		}
+
+		memcpy(&recRAMCopy[HWADDR(startpc) / 4], PSM(startpc), endpc - startpc);
+	}
+
+	s_pCurBlock->SetFnptr((uptr)recPtr);
+
+	for(u32 i = 1; i < (u32)s_pCurBlockEx->size; i++) {
+		if ((uptr)JITCompile == s_pCurBlock[i].GetFnptr())
+			s_pCurBlock[i].SetFnptr((uptr)JITCompileInBlock);
+	}
+
+	if( !(endpc&0x10000000) )
+		maxrecmem = std::max( (endpc&~0xa0000000), maxrecmem );
+}
+
+// Copies startpc's block out of the block cache instead of compiling it, if it was compiled
+// for the same guest code, page protection and block boundaries.  recPtr is where the
+// block goes, with room for any block.
+static bool recRestoreBlock(u32 startpc)
+{
+	if (ElfCRC != s_blockCache.GetCrc() && EmuConfig.RecBlockCache)
+	{
+		s_blockCache.SetTable(0, recLutReserve_RAM, recLutSize);
+		s_blockCache.SetTable(1, vtlb_private::vtlbdata.fastmem, _4gb);
+		s_blockCache.SetConstBuffer(recConstBuf, RECCONSTBUF_SIZE * sizeof(*recConstBuf), recBlockCacheConst);
+		s_blockCache.Open(ElfCRC);
+	}
+
+	if (!recBlockCacheable(startpc))
+		return false;
+
+	const u32 paddr = HWADDR(startpc);
+	const RecBlockCache::Block* block = s_blockCache.Find(startpc, paddr, (const u32*)PSM(startpc));
+	if (!block)
+		return false;
+
+	const vtlb_ProtectionMode protection = recGetProtection(startpc);
+	if (protection == ProtMode_Manual
+		|| (protection != ProtMode_NotRequired) != !!(block->flags & RecBlockCache::Block_Protected))
+		return false;
+
+	const bool superblock = !!(block->flags & RecBlockCache::Block_Superblock);
+	if (superblock)
+	{
+		if (!recSuperblockEligible(startpc))
+			return false;
+	}
+	else
+	{
+		// normal blocks end where another one starts, and hot ones get recompiled as superblocks
+		if (s_superblockHot.count(paddr))
+			return false;
+
+		for (u32 i = 1; i < block->size; i++)
+		{
+			const uptr fnptr = PC_GETBLOCK(startpc + i * 4)->GetFnptr();
+			if (fnptr != (uptr)JITCompile && fnptr != (uptr)JITCompileInBlock)
+				return false;
+		}
+	}
+
+	if (!s_blockCache.Restore(block, recPtr))
+		return false;
+
+	s_pCurBlock = PC_GETBLOCK(startpc);
+	s_pCurBlockEx = recBlocks.New(paddr, (uptr)recPtr);
+	s_pCurBlockEx->size = block->size;
+	s_pCurBlockEx->x86size = block->codeSize;
+	s_blockCache.Link(block, recPtr, recBlocks);
+
+	if (protection != ProtMode_NotRequired)
+		recProtectBlockPage(paddr, block->range * 4);
+	if (superblock)
+		s_superblockHot.insert(paddr);
+
+	recCommitBlock(startpc, startpc + block->size * 4);
+	recPtr += block->codeSize;
+
+	s_pCurBlock = NULL;
+	s_pCurBlockEx = NULL;
+	return true;
+}
+
 static void __fastcall recRecompile( const u32 startpc )
 {
 	u32 i = 0;
@@ -1607,11 +2102,13 @@ static void __fastcall recRecompile( const u32 startpc )
 
 	pxAssert( startpc );
 
-	// if recPtr reached the mem limit reset whole mem
-	if (recPtr >= (recMem->GetPtrEnd() - _64kb)) {
-		eeRecNeedsReset = true;
+	// if recPtr reached the end of its cache region, make room in the next one
+	if (recPtr >= (recCacheRegionStart(s_recCacheRegion + 1) - _64kb)) {
+		recEvictCacheRegion();
 	}
-	else if ((recConstBufPtr - recConstBuf) >= RECCONSTBUF_SIZE - 64) {
+
+	// constants aren't tracked per block, so running out of them still resets everything
+	if ((recConstBufPtr - recConstBuf) >= RECCONSTBUF_SIZE - 64) {
 		log_cb(RETRO_LOG_DEBUG, "EE recompiler stack reset\n");
 		eeRecNeedsReset = true;
 	}
@@ -1621,6 +2118,12 @@ static void __fastcall recRecompile( const u32 startpc )
 	xSetPtr( recPtr );
 	recPtr = xGetAlignedCallTarget();
 
+	if (recRestoreBlock(startpc))
+		return;
+
+	if (recBlockCacheable(startpc))
+		s_blockCache.BeginBlock(recPtr, true);
+
 #ifndef NDEBUG
 	if (0x8000d618 == startpc)
 		log_cb(RETRO_LOG_DEBUG, "Compiling block @ 0x%08x\n", startpc);
@@ -1638,6 +2141,25 @@ static void __fastcall recRecompile( const u32 startpc )
 
 	pxAssert(s_pCurBlockEx);
 
+	if (EmuConfig.EEBlockProfiler)
+		xFastCall((void*)recProfileBlock, EE::BlockProfiler.BeginBlock(HWADDR(startpc)));
+
+	s_nSuperblock = false;
+	s_superblockEntryCount = 0;
+	if (recSuperblockEligible(startpc))
+	{
+		if (s_superblockHot.count(HWADDR(startpc)))
+			s_nSuperblock = true;
+		else
+		{
+			// tier-up counter, see recPromoteBlock
+			xSUB(ptr32[&s_superblockCounters[(HWADDR(startpc) >> 2) & (SuperblockCounterCount - 1)]], 1);
+			xForwardJNZ8 notHot;
+			xFastCall(recPromoteBlock, startpc);
+			notHot.SetTarget();
+		}
+	}
+
 	if (HWADDR(startpc) == EELOAD_START)
 	{
 		// The EELOAD _start function is the same across all BIOS versions
@@ -1694,6 +2216,7 @@ static void __fastcall recRecompile( const u32 startpc )
 	s_nBlockCycles = 0;
 	pc = startpc;
 	g_cpuHasConstReg = g_cpuFlushedConstReg = 1;
+	g_fpuClampedRegs = 0;
 	pxAssert( g_cpuConstRegs[0].UD[0] == 0 );
 
 	_initX86regs();
@@ -1745,7 +2268,8 @@ static void __fastcall recRecompile( const u32 startpc )
 				break;
 			}
 
-			if (pblock->GetFnptr() != (uptr)JITCompile && pblock->GetFnptr() != (uptr)JITCompileInBlock)
+			// superblocks may overlap other blocks
+			if (!s_nSuperblock && pblock->GetFnptr() != (uptr)JITCompile && pblock->GetFnptr() != (uptr)JITCompileInBlock)
 			{
 				willbranch3 = 1;
 				s_nEndBlock = i;
@@ -1769,7 +2293,7 @@ static void __fastcall recRecompile( const u32 startpc )
 				if( _Rt_ < 4 || (_Rt_ >= 16 && _Rt_ < 20) ) {
 					// branches
 					s_branchTo = _Imm_ * 4 + i + 4;
-					if( s_branchTo > startpc && s_branchTo < i ) s_nEndBlock = s_branchTo;
+					if( !s_superblockEntryCount && s_branchTo > startpc && s_branchTo < i ) s_nEndBlock = s_branchTo;
 					else  s_nEndBlock = i+8;
 
 					goto StartRecomp;
@@ -1780,13 +2304,32 @@ static void __fastcall recRecompile( const u32 startpc )
 			case 3: // JAL
 				s_branchTo = _InstrucTarget_ << 2 | (i + 4) & 0xf0000000;
 				s_nEndBlock = i + 8;
+				if (_Opcode_ == 2 && recSuperblockFollow(startpc, i, s_branchTo)) {
+					i = s_branchTo;
+					continue;
+				}
 				goto StartRecomp;
 
 			// branches
 			case 4: case 5: case 6: case 7:
 			case 20: case 21: case 22: case 23:
 				s_branchTo = _Imm_ * 4 + i + 4;
-				if( s_branchTo > startpc && s_branchTo < i ) s_nEndBlock = s_branchTo;
+				if (_Opcode_ == 4 && _Rs_ == _Rt_) { // B
+					if (recSuperblockFollow(startpc, i, s_branchTo)) {
+						s_nEndBlock = i + 8;
+						i = s_branchTo;
+						continue;
+					}
+				}
+				else if ((_Opcode_ == 4 || _Opcode_ == 5) && s_branchTo > i) {
+					// forward BEQ/BNE: guess not taken, the taken side becomes a side exit
+					if (recSuperblockFollow(startpc, i, i + 8)) {
+						s_nEndBlock = i + 8;
+						i += 8;
+						continue;
+					}
+				}
+				if( !s_superblockEntryCount && s_branchTo > startpc && s_branchTo < i ) s_nEndBlock = s_branchTo;
 				else  s_nEndBlock = i+8;
 
 				goto StartRecomp;
@@ -1807,7 +2350,7 @@ static void __fastcall recRecompile( const u32 startpc )
 					// BC1F, BC1T, BC1FL, BC1TL
 					// BC2F, BC2T, BC2FL, BC2TL
 					s_branchTo = _Imm_ * 4 + i + 4;
-					if( s_branchTo > startpc && s_branchTo < i ) s_nEndBlock = s_branchTo;
+					if( !s_superblockEntryCount && s_branchTo > startpc && s_branchTo < i ) s_nEndBlock = s_branchTo;
 					else  s_nEndBlock = i+8;
 
 					goto StartRecomp;
@@ -1830,7 +2373,7 @@ StartRecomp:
 	// without a significant loss in cycle accuracy is with a division, but games would probably
 	// be happy with time wasting loops completing in 0 cycles and timeouts waiting forever.
 	s_nBlockFF = false;
-	if (s_branchTo == startpc) {
+	if (s_branchTo == startpc && !s_superblockEntryCount) {
 		s_nBlockFF = true;
 
 		u32 reads = 0, loads = 1;
@@ -1859,6 +2402,24 @@ StartRecomp:
 					break;
 				}
 			}
+			// shifts by an immediate or by a register (SLL..SRAV, DSLL..DSRA32)
+			else if (_Opcode_ == 0 && ((_Funct_ & 070) == 0 || (_Funct_ & 070) == 070) && (_Funct_ & 3) != 1)
+			{
+				u32 sources = 1 << _Rt_;
+				if ((_Funct_ & 074) == 004)
+					sources |= 1 << _Rs_;
+
+				if ((loads & sources) == sources) {
+					loads |= 1 << _Rd_;
+					continue;
+				}
+				else
+					reads |= sources;
+				if (reads & 1 << _Rd_) {
+					s_nBlockFF = false;
+					break;
+				}
+			}
 			// common register arithmetic instructions
 			else if (_Opcode_ == 0 && (_Funct_ & 060) == 040 && (_Funct_ & 076) != 050)
 			{
@@ -1898,6 +2459,10 @@ StartRecomp:
 				break;
 			}
 		}
+
+		if (s_nBlockFF && EmuConfig.Speedhacks.WaitLoop && s_idleLoops.insert(startpc).second)
+			log_cb(RETRO_LOG_INFO, "EE/iR5900-32 idle loop at 0x%08x (%u instructions)\n",
+				startpc, (s_nEndBlock - startpc) / 4);
 	}
 
 	// rec info //
@@ -1961,7 +2526,8 @@ StartRecomp:
 	}
 
 	// Detect and handle self-modified code
-	memory_protect_recompiled_code(startpc, (s_nEndBlock-startpc) >> 2);
+	s_smcGuardJump = NULL;
+	const vtlb_ProtectionMode protection = memory_protect_recompiled_code(startpc, (s_nEndBlock-startpc) >> 2);
 
 	// Skip Recompilation if sceMpegIsEnd Pattern detected
 	bool doRecompilation = !skipMPEG_By_Pattern(startpc);
@@ -1977,41 +2543,7 @@ StartRecomp:
 	pxAssert( (pc-startpc)>>2 <= 0xffff );
 	s_pCurBlockEx->size = (pc-startpc)>>2;
 
-	if (HWADDR(pc) <= Ps2MemSize::MainRam) {
-		BASEBLOCKEX *oldBlock;
-		int i;
-
-		i = recBlocks.LastIndex(HWADDR(pc) - 4);
-		while (oldBlock = recBlocks[i--]) {
-			if (oldBlock == s_pCurBlockEx)
-				continue;
-			if (oldBlock->startpc >= HWADDR(pc))
-				continue;
-			if ((oldBlock->startpc + oldBlock->size * 4) <= HWADDR(startpc))
-				break;
-
-			if (memcmp(&recRAMCopy[oldBlock->startpc / 4], PSM(oldBlock->startpc),
-			           oldBlock->size * 4))
-			{
-				recClear(startpc, (pc - startpc) / 4);
-				s_pCurBlockEx = recBlocks.Get(HWADDR(startpc));
-				pxAssert(s_pCurBlockEx->startpc == HWADDR(startpc));
-				break;
-			}
-		}
-
-		memcpy(&recRAMCopy[HWADDR(startpc) / 4], PSM(startpc), pc - startpc);
-	}
-
-	s_pCurBlock->SetFnptr((uptr)recPtr);
-
-	for(i = 1; i < (u32)s_pCurBlockEx->size; i++) {
-		if ((uptr)JITCompile == s_pCurBlock[i].GetFnptr())
-			s_pCurBlock[i].SetFnptr((uptr)JITCompileInBlock);
-	}
-
-	if( !(pc&0x10000000) )
-		maxrecmem = std::max( (pc&~0xa0000000), maxrecmem );
+	recCommitBlock(startpc, pc);
 
 	if( g_branch == 2 )
 	{
@@ -2026,7 +2558,8 @@ StartRecomp:
 	}
 	else
 	{
-		if( g_branch )
+		// a superblock can leave through a branch before reaching the end of its range
+		if( g_branch && !s_nSuperblock )
 			pxAssert( !willbranch3 );
 
 		if( willbranch3 || !g_branch) {
@@ -2046,23 +2579,38 @@ StartRecomp:
 			{
 				xMOV( ptr32[&cpuRegs.pc], pc );
 				xADD( ptr32[&cpuRegs.cycle], scaleblockcycles() );
-				recBlocks.Link( HWADDR(pc), xJcc32() );
+				recLinkBlock( HWADDR(pc), xJcc32() );
 			}
 		}
 	}
 
+	vtlb_DynGenFastmemStubs();
+	recEmitSmcGuardCheck(startpc, (s_nEndBlock-startpc) >> 2);
+
 	pxAssert( xGetPtr() < recMem->GetPtrEnd() );
 	pxAssert( recConstBufPtr < recConstBuf + RECCONSTBUF_SIZE );
 
 	pxAssert(xGetPtr() - recPtr < _64kb);
 	s_pCurBlockEx->x86size = xGetPtr() - recPtr;
+	EE::BlockProfiler.EndBlock(s_pCurBlockEx->size, s_pCurBlockEx->x86size);
 
 	recPtr = xGetPtr();
 
 	pxAssert( (g_cpuHasConstReg&g_cpuFlushedConstReg) == g_cpuHasConstReg );
 
+	// blocks checking their code inline are counted and cleared by page, keep them out
+	if (protection != ProtMode_Manual)
+		s_blockCache.EndBlock(startpc, HWADDR(startpc), s_pCurBlockEx->size, (s_nEndBlock-startpc) >> 2,
+			(s_nSuperblock ? RecBlockCache::Block_Superblock : 0)
+			| (protection != ProtMode_NotRequired ? RecBlockCache::Block_Protected : 0),
+			(const u32*)PSM(startpc), recPtr);
+	else
+		s_blockCache.CancelBlock();
+
 	s_pCurBlock = NULL;
 	s_pCurBlockEx = NULL;
+	s_nSuperblock = false;
+	s_superblockEntryCount = 0;
 }
 
 // The only *safe* way to throw exceptions from the context of recompiled code.
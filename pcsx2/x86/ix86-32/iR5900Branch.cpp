@@ -224,7 +224,7 @@ void recBEQ_const()
 		branchTo = pc+4;
 
 	recompileNextInstruction(1);
-	SetBranchImm( branchTo );
+	SetBranchImmOrContinue( branchTo );
 }
 
 void recBEQ_process(int info, int process)
@@ -234,7 +234,7 @@ void recBEQ_process(int info, int process)
 	if ( _Rs_ == _Rt_ )
 	{
 		recompileNextInstruction(1);
-		SetBranchImm( branchTo );
+		SetBranchImmOrContinue( branchTo );
 	}
 	else
 	{
@@ -253,7 +253,7 @@ void recBEQ_process(int info, int process)
 		LoadBranchState();
 		recompileNextInstruction(1);
 
-		SetBranchImm(pc);
+		SetBranchImmOrContinue(pc);
 	}
 }
 
@@ -274,7 +274,7 @@ void recBNE_const()
 		branchTo = pc+4;
 
 	recompileNextInstruction(1);
-	SetBranchImm( branchTo );
+	SetBranchImmOrContinue( branchTo );
 }
 
 void recBNE_process(int info, int process)
@@ -284,7 +284,7 @@ void recBNE_process(int info, int process)
 	if ( _Rs_ == _Rt_ )
 	{
 		recompileNextInstruction(1);
-		SetBranchImm(pc);
+		SetBranchImmOrContinue(pc);
 		return;
 	}
 
@@ -302,7 +302,7 @@ void recBNE_process(int info, int process)
 	LoadBranchState();
 	recompileNextInstruction(1);
 
-	SetBranchImm(pc);
+	SetBranchImmOrContinue(pc);
 }
 
 void recBNE_(int info) { recBNE_process(info, 0); }
@@ -54,7 +54,7 @@ void recJ()
 	if (EmuConfig.Gamefixes.GoemonTlbHack)
 		SetBranchImm(vtlb_V2P(newpc));
 	else
-		SetBranchImm(newpc);
+		SetBranchImmOrContinue(newpc);
 }
 
 ////////////////////////////////////////////////////
@@ -76,6 +76,10 @@ void recJAL()
 	}
 
 	recompileNextInstruction(1);
+
+	iFlushCall(FLUSH_EVERYTHING);
+	recPushReturnAddress(pc);
+
 	if (EmuConfig.Gamefixes.GoemonTlbHack)
 		SetBranchImm(vtlb_V2P(newpc));
 	else
@@ -91,7 +95,7 @@ void recJAL()
 void recJR()
 {
 
-	SetBranchReg( _Rs_);
+	SetBranchReg( _Rs_, _Rs_ == 31 );
 }
 
 ////////////////////////////////////////////////////
@@ -153,6 +157,12 @@ void recJALR()
 		xMOV(ptr[&cpuRegs.pc], eax);
 	}
 
+	if (_Rd_ == 31)
+	{
+		iFlushCall(FLUSH_EVERYTHING);
+		recPushReturnAddress(newpc);
+	}
+
 	SetBranchReg(0xffffffff);
 }
 
@@ -496,6 +496,7 @@ void recLWC1()
 	recCall(::R5900::Interpreter::OpcodeImpl::LWC1);
 #else
 	_deleteFPtoXMMreg(_Rt_, 2);
+	FPU_SET_CLAMPED(_Rt_, false);
 
 	if (GPR_IS_CONST1(_Rs_))
 	{
@@ -22,6 +22,8 @@
 #include "iCore.h"
 #include "iR5900.h"
 
+#include <map>
+
 using namespace vtlb_private;
 using namespace x86Emitter;
 
@@ -364,12 +366,295 @@ static void vtlb_SetWriteback(u32 *writeback)
 	*writeback = val;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+//                            Fastmem Implementations
+// With fastmem (see vtlb_Fastmem_Init) a load/store with a run-time address is emitted as
+// a single access to [vtlbdata.fastmem + addr], and the regular vtlb access is emitted as a
+// stub at the end of the block.  If the fast access faults (the page isn't main memory),
+// the fault handler rewrites the start of the site into a jump to its stub and resumes
+// execution in the stub, so each site faults at most once.
+//
+// Stores to write protected ram also fault, but those are handled by mmap_PageFaultHandler
+// like any other store to protected ram, and the site stays fast.
+
+struct FastmemSite
+{
+	u8* start;		// loads the fastmem base, backpatched into a jump to the stub
+	u8* access[2];	// the instructions touching guest memory (two for 128 bit)
+	u8* done;
+	u8 mode;
+	u8 bits;
+	bool sign;
+};
+
+struct FastmemStub
+{
+	u8* start;
+	u8* stub;
+};
+
+// Sites of the block being recompiled, their stubs are emitted by vtlb_DynGenFastmemStubs.
+static std::vector<FastmemSite> s_fastmemPending;
+
+// Faulting instruction -> site, for all sites that haven't been backpatched yet.
+static std::map<uptr, FastmemStub> s_fastmemSites;
+
+// Pages resolved at compile time by the _Const accesses, see vtlb_DynGenTrackConstPages.
+static std::vector<u32>* s_constPages = NULL;
+
+class FastmemFaultHandler : public EventListener_PageFault
+{
+public:
+	void OnPageFaultEvent( const PageFaultInfo& info, bool& handled );
+};
+
+static FastmemFaultHandler* s_fastmemFaultHandler = NULL;
+
+static void DynGen_FastmemInstallHandler()
+{
+	if (!s_fastmemFaultHandler)
+	{
+		pxAssert( Source_PageFault );
+		s_fastmemFaultHandler = new FastmemFaultHandler();
+	}
+}
+
+void FastmemFaultHandler::OnPageFaultEvent( const PageFaultInfo& info, bool& handled )
+{
+	if (!info.pc)
+		return;
+
+	auto it = s_fastmemSites.find(*info.pc);
+	if (it == s_fastmemSites.end())
+		return;
+
+	// A store to a write protected page; mmap_PageFaultHandler deals with it.
+	u32 ramoffset;
+	if (vtlb_FastmemGetRamOffset(info.addr, ramoffset))
+		return;
+
+	u8* start = it->second.start;
+	u8* stub = it->second.stub;
+
+	start[0] = 0xe9; // jmp rel32
+	*(s32*)(start + 1) = (s32)(stub - (start + 5));
+
+	// Both instructions of a 128 bit access point to the same site.
+	for (auto i = s_fastmemSites.lower_bound((uptr)start); i != s_fastmemSites.end() && i->second.start == start; )
+		i = s_fastmemSites.erase(i);
+
+	*info.pc = (uptr)stub;
+	handled = true;
+}
+
+// Emits the fast access of a site.  arg1reg holds the address (zero extended), arg2reg
+// the data or a pointer to it, like for the regular path.  64 and 128 bit moves use rax
+// rather than an xmm register: the stub jumps back past the access, which must not leave
+// a borrowed xmm register unrestored.
+static void DynGen_FastmemAccess( FastmemSite& site )
+{
+	site.access[1] = NULL;
+
+	if (!site.mode)
+	{
+		site.access[0] = xGetPtr();
+		switch( site.bits )
+		{
+			case 8:
+				if( site.sign )
+					xMOVSX( eax, ptr8[rbx+arg1reg] );
+				else
+					xMOVZX( eax, ptr8[rbx+arg1reg] );
+			break;
+
+			case 16:
+				if( site.sign )
+					xMOVSX( eax, ptr16[rbx+arg1reg] );
+				else
+					xMOVZX( eax, ptr16[rbx+arg1reg] );
+			break;
+
+			case 32:
+				xMOV( eax, ptr32[rbx+arg1reg] );
+			break;
+
+			case 64:
+				xMOV( rax, ptr64[rbx+arg1reg] );
+				xMOV( ptr64[arg2reg], rax );
+			break;
+
+			case 128:
+				xMOV( rax, ptr64[rbx+arg1reg] );
+				xMOV( ptr64[arg2reg], rax );
+				site.access[1] = xGetPtr();
+				xMOV( rax, ptr64[rbx+arg1reg+8] );
+				xMOV( ptr64[arg2reg+8], rax );
+			break;
+
+			jNO_DEFAULT
+		}
+	}
+	else
+	{
+		switch( site.bits )
+		{
+			case 8:
+				xMOV( edx, arg2regd );
+				site.access[0] = xGetPtr();
+				xMOV( ptr[rbx+arg1reg], dl );
+			break;
+
+			case 16:
+				site.access[0] = xGetPtr();
+				xMOV( ptr[rbx+arg1reg], xRegister16(arg2reg) );
+			break;
+
+			case 32:
+				site.access[0] = xGetPtr();
+				xMOV( ptr[rbx+arg1reg], arg2regd );
+			break;
+
+			case 64:
+				xMOV( rax, ptr64[arg2reg] );
+				site.access[0] = xGetPtr();
+				xMOV( ptr64[rbx+arg1reg], rax );
+			break;
+
+			case 128:
+				xMOV( rax, ptr64[arg2reg] );
+				site.access[0] = xGetPtr();
+				xMOV( ptr64[rbx+arg1reg], rax );
+				xMOV( rax, ptr64[arg2reg+8] );
+				site.access[1] = xGetPtr();
+				xMOV( ptr64[rbx+arg1reg+8], rax );
+			break;
+
+			jNO_DEFAULT
+		}
+	}
+}
+
+// Returns false if fastmem is off and the caller should emit the regular vtlb access.
+static bool DynGen_Fastmem( int mode, u32 bits, bool sign )
+{
+	if (wordsize != 8 || !vtlbdata.fastmem)
+		return false;
+
+	DynGen_FastmemInstallHandler();
+
+	FastmemSite site;
+	site.mode = mode;
+	site.bits = bits;
+	site.sign = sign;
+
+	site.start = xGetPtr();
+#ifdef __M_X86_64
+	xMOV64( rbx, (sptr)vtlbdata.fastmem );
+#endif
+	pxAssert( xGetPtr() - site.start >= 5 );
+
+	DynGen_FastmemAccess( site );
+	site.done = xGetPtr();
+
+	s_fastmemPending.push_back( site );
+	return true;
+}
+
+// Emits the vtlb stubs of the sites of the current block.  Called once the block's own
+// code is complete.  The stubs use the same registers as the fast accesses, and leave the
+// same ones behind.
+void vtlb_DynGenFastmemStubs()
+{
+	for (const FastmemSite& site : s_fastmemPending)
+	{
+		u8* stub = xGetPtr();
+
+		u32* writeback = DynGen_PrepRegs();
+		DynGen_IndirectDispatch( site.mode, site.bits, site.sign && site.bits < 32 );
+
+		switch( site.bits )
+		{
+			case 8:
+			case 16:
+			case 32:
+				if (site.mode)
+					DynGen_DirectWrite( site.bits );
+				else
+					DynGen_DirectRead( site.bits, site.sign );
+			break;
+
+			case 64:
+			case 128:
+				if (site.mode)
+				{
+					xMOV( rax, ptr64[arg2reg] );
+					xMOV( ptr64[arg1reg], rax );
+					if (site.bits == 128)
+					{
+						xMOV( rax, ptr64[arg2reg+8] );
+						xMOV( ptr64[arg1reg+8], rax );
+					}
+				}
+				else
+				{
+					xMOV( rax, ptr64[arg1reg] );
+					xMOV( ptr64[arg2reg], rax );
+					if (site.bits == 128)
+					{
+						xMOV( rax, ptr64[arg1reg+8] );
+						xMOV( ptr64[arg2reg+8], rax );
+					}
+				}
+			break;
+		}
+
+		vtlb_SetWriteback(writeback);
+		xJMP( site.done );
+
+		s_fastmemSites[(uptr)site.access[0]] = { site.start, stub };
+		if (site.access[1])
+			s_fastmemSites[(uptr)site.access[1]] = { site.start, stub };
+	}
+
+	s_fastmemPending.clear();
+}
+
+// Forgets the sites in [start, end) of the code cache, which is about to be reused.
+void vtlb_DynGenFastmemClear(uptr start, uptr end)
+{
+	s_fastmemPending.clear();
+	s_fastmemSites.erase(s_fastmemSites.lower_bound(start), s_fastmemSites.lower_bound(end));
+}
+
+// Lists the sites of the code in [start, end) that haven't been backpatched.
+void vtlb_DynGenFastmemGetSites(uptr start, uptr end, std::vector<vtlb_FastmemSite>& sites)
+{
+	sites.clear();
+	for (auto it = s_fastmemSites.lower_bound(start); it != s_fastmemSites.end() && it->first < end; ++it)
+		sites.push_back({ it->first, (uptr)it->second.start, (uptr)it->second.stub });
+}
+
+// Registers a site of code that was copied into the code cache rather than emitted.
+void vtlb_DynGenFastmemAddSite(const vtlb_FastmemSite& site)
+{
+	DynGen_FastmemInstallHandler();
+	s_fastmemSites[site.access] = { (u8*)site.start, (u8*)site.stub };
+}
+
+void vtlb_DynGenTrackConstPages(std::vector<u32>* pages)
+{
+	s_constPages = pages;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //                            Dynarec Load Implementations
 void vtlb_DynGenRead64(u32 bits)
 {
 	pxAssume( bits == 64 || bits == 128 );
 
+	if (DynGen_Fastmem( 0, bits, false ))
+		return;
+
 	u32* writeback = DynGen_PrepRegs();
 
 	DynGen_IndirectDispatch( 0, bits );
@@ -386,6 +671,9 @@ void vtlb_DynGenRead32(u32 bits, bool sign)
 {
 	pxAssume( bits <= 32 );
 
+	if (DynGen_Fastmem( 0, bits, sign && bits < 32 ))
+		return;
+
 	u32* writeback = DynGen_PrepRegs();
 
 	DynGen_IndirectDispatch( 0, bits, sign && bits < 32 );
@@ -399,6 +687,9 @@ void vtlb_DynGenRead32(u32 bits, bool sign)
 // recompiler if the TLB is changed.
 void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const )
 {
+	if (s_constPages)
+		s_constPages->push_back(addr_const>>VTLB_PAGE_BITS);
+
 	auto vmv = vtlbdata.vmap[addr_const>>VTLB_PAGE_BITS];
 	if( !vmv.isHandler(addr_const) )
 	{
@@ -443,6 +734,9 @@ void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const )
 //
 void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const )
 {
+	if (s_constPages)
+		s_constPages->push_back(addr_const>>VTLB_PAGE_BITS);
+
 	auto vmv = vtlbdata.vmap[addr_const>>VTLB_PAGE_BITS];
 	if( !vmv.isHandler(addr_const) )
 	{
@@ -516,6 +810,9 @@ void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const )
 
 void vtlb_DynGenWrite(u32 sz)
 {
+	if (DynGen_Fastmem( 1, sz, false ))
+		return;
+
 	u32* writeback = DynGen_PrepRegs();
 
 	DynGen_IndirectDispatch( 1, sz );
@@ -531,6 +828,9 @@ void vtlb_DynGenWrite(u32 sz)
 // recompiler if the TLB is changed.
 void vtlb_DynGenWrite_Const( u32 bits, u32 addr_const )
 {
+	if (s_constPages)
+		s_constPages->push_back(addr_const>>VTLB_PAGE_BITS);
+
 	auto vmv = vtlbdata.vmap[addr_const>>VTLB_PAGE_BITS];
 	if( !vmv.isHandler(addr_const) )
 	{
@@ -47,7 +47,21 @@ void mVUinit(microVU& mVU, uint vuIndex) {
 
 	if(!x86caps.hasStreamingSIMD2Extensions) mVUthrowHardwareDeficiency( L"SSE2", vuIndex );
 
-	memzero(mVU.prog);
+	// prog holds an unordered_multimap, so it can't simply be zeroed
+	memzero(mVU.prog.IRinfo);
+	memzero(mVU.prog.prog);
+	memzero(mVU.prog.quick);
+	memzero(mVU.prog.lpState);
+	mVU.prog.index.clear();
+	mVU.prog.stats.Reset();
+	mVU.prog.cur		= NULL;
+	mVU.prog.total		= 0;
+	mVU.prog.isSame		= 0;
+	mVU.prog.cleared	= 0;
+	mVU.prog.curFrame	= 0;
+	mVU.prog.x86ptr		= NULL;
+	mVU.prog.x86start	= NULL;
+	mVU.prog.x86end		= NULL;
 
 	mVU.index			=  vuIndex;
 	mVU.cop2			=  0;
@@ -114,6 +128,7 @@ void mVUreset(microVU& mVU, bool resetReserve) {
 		}
 		std::deque<microProgram*>::iterator it(mVU.prog.prog[i]->begin());
 		for ( ; it != mVU.prog.prog[i]->end(); ++it) {
+			mVUprogCache[mVU.index].keep(mVU, *it[0]);
 			mVUdeleteProg(mVU, it[0]);
 		}
 		mVU.prog.prog[i]->clear();
@@ -129,6 +144,10 @@ void mVUclose(microVU& mVU) {
 
 	safe_delete  (mVU.cache_reserve);
 
+	mVUprogCache[mVU.index].open(mVU, 0); // Save the program cache
+	mVU.prog.stats.Print(mVU.index);
+	mVU.prog.stats.Reset();
+
 	// Delete Programs and Block Managers
 	for (u32 i = 0; i < (mVU.progSize / 2); i++) {
 		if (!mVU.prog.prog[i]) continue;
@@ -161,12 +180,32 @@ __ri void mVUvsyncUpdate(mV) {
 	//mVU.prog.curFrame++;
 }
 
+// Removes prog from the hash index
+static void mVUunindexProg(microVU& mVU, microProgram& prog) {
+	auto range = mVU.prog.index.equal_range(prog.hash);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == &prog) {
+			mVU.prog.index.erase(it);
+			return;
+		}
+	}
+}
+
+// (Re)indexes prog under the hash of its data
+void mVUindexProg(microVU& mVU, microProgram& prog, u64 hash) {
+	mVUunindexProg(mVU, prog);
+	prog.hash = hash;
+	mVU.prog.index.emplace(hash, &prog);
+}
+
 // Deletes a program
 __ri void mVUdeleteProg(microVU& mVU, microProgram*& prog) {
+	mVUunindexProg(mVU, *prog);
 	for (u32 i = 0; i < (mVU.progSize / 2); i++) {
 		safe_delete(prog->block[i]);
 	}
 	safe_delete(prog->ranges);
+	safe_delete(prog->entries);
 	safe_aligned_free(prog);
 }
 
@@ -176,6 +215,7 @@ __ri microProgram* mVUcreateProg(microVU& mVU, int startPC) {
 	memset(prog, 0, sizeof(microProgram));
 	prog->idx     = mVU.prog.total++;
 	prog->ranges  = new std::deque<microRange>();
+	prog->entries = new std::vector<microProgEntry>();
 	prog->startPC = startPC;
 	mVUcacheProg(mVU, *prog); // Cache Micro Program
 #ifndef NDEBUG
@@ -192,6 +232,7 @@ __ri microProgram* mVUcreateProg(microVU& mVU, int startPC) {
 __ri void mVUcacheProg(microVU& mVU, microProgram& prog) {
 	if (!mVU.index)	memcpy(prog.data, mVU.regs().Micro, 0x1000);
 	else			memcpy(prog.data, mVU.regs().Micro, 0x4000);
+	mVUindexProg(mVU, prog, vuMicroHash[mVU.index]); // prog.data is the micro memory now
 	mVUdumpProg(mVU, prog);
 }
 
@@ -263,14 +304,37 @@ __fi bool mVUcmpProg(microVU& mVU, microProgram& prog, const bool cmpWholeProg)
 // Searches for Cached Micro Program and sets prog.cur to it (returns entry-point to program)
 _mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState) {
 	microVU& mVU = mVUx;
+	mVUcacheCheck(mVU);
 	microProgramQuick& quick = mVU.prog.quick[mVU.regs().start_pc / 8];
 	microProgramList* list = mVU.prog.prog[mVU.regs().start_pc / 8];
 
 	if(!quick.prog) { // If null, we need to search for new program
+		// A program cached from exactly the current micro memory is found through the hash
+		// index with a single compare; anything else needs the scan over the ranges below.
+		auto range = mVU.prog.index.equal_range(vuMicroHash[mVU.index]);
+		for (auto hit = range.first; hit != range.second; ++hit) {
+			microProgram* prog = hit->second;
+			if (prog->startPC != mVU.regs().start_pc / 8) continue;
+			mVU.prog.stats.compares++;
+			if (mVUcmpProg(mVU, *prog, 1)) {
+				mVU.prog.stats.hashHits++;
+				quick.block = prog->block[startPC/8];
+				quick.prog  = prog;
+				list->erase(std::find(list->begin(), list->end(), prog));
+				list->push_front(prog);
+				if (quick.block == nullptr)
+					return mVUblockFetch(mVU, startPC, pState);
+				return mVUentryGet(mVU, quick.block, startPC, pState);
+			}
+		}
+		mVU.prog.stats.hashMisses++;
+
 		std::deque<microProgram*>::iterator it(list->begin());
 		for ( ; it != list->end(); ++it) {
+			mVU.prog.stats.compares++;
 			bool b = mVUcmpProg(mVU, *it[0], 0);
 			if (b) {
+				mVU.prog.stats.scanHits++;
 				quick.block = it[0]->block[startPC/8];
 				quick.prog  = it[0];
 				list->erase(it);
@@ -313,13 +377,62 @@ _mVUt __fi void* mVUsearchProg(u32 startPC, uptr pState) {
 	return mVUentryGet(mVU, quick.block, startPC, pState);
 }
 
+// Compiles startPC of the current micro memory for the pipeline state the next execution
+// starts with, into the program mVUsearchProg will pick for it, without making that program
+// the current one.  The execution then finds the block compiled already.
+void mVUcompileAhead(microVU& mVU, u32 startPC) {
+	startPC &= mVU.microMemSize - 8;
+	if (mVU.prog.x86ptr >= mVU.prog.x86end) return; // the next execution resets the rec-cache
+
+	microProgram* cur	= mVU.prog.cur;
+	const int isSame	= mVU.prog.isSame;
+	const int cleared	= mVU.prog.cleared;
+	microProgramList* list = mVU.prog.prog[startPC / 8];
+
+	// Same search order as mVUsearchProg
+	microProgram* prog = NULL;
+	auto range = mVU.prog.index.equal_range(vuMicroHash[mVU.index]);
+	for (auto hit = range.first; hit != range.second && !prog; ++hit) {
+		if (hit->second->startPC == startPC / 8 && mVUcmpProg(mVU, *hit->second, 1))
+			prog = hit->second;
+	}
+	for (auto it = list->begin(); it != list->end() && !prog; ++it) {
+		if (mVUcmpProg(mVU, *it[0], 0))
+			prog = it[0];
+	}
+	if (!prog) {
+		prog = mVUcreateProg(mVU, startPC / 8);
+		list->push_front(prog);
+		mVU.prog.cur	= prog;
+		mVU.prog.isSame = 1;
+	}
+
+	if (!prog->block[startPC / 8] || !prog->block[startPC / 8]->search(&mVU.prog.lpState)) {
+		xSetPtr(mVU.prog.x86ptr);
+		mVUblockFetch(mVU, startPC, (uptr)&mVU.prog.lpState);
+		mVU.prog.x86ptr = xGetPtr();
+		mVU.prog.stats.compiledAhead++;
+	}
+
+	mVU.prog.cur		= cur;
+	mVU.prog.isSame		= isSame;
+	mVU.prog.cleared	= cleared;
+}
+
 //------------------------------------------------------------------
 // recMicroVU0 / recMicroVU1
 //------------------------------------------------------------------
 recMicroVU0::recMicroVU0()		  { m_Idx = 0; IsInterpreter = false; }
 recMicroVU1::recMicroVU1()		  { m_Idx = 1; IsInterpreter = false; }
-void recMicroVU0::Vsync() noexcept { mVUvsyncUpdate(microVU0); }
-void recMicroVU1::Vsync() noexcept { mVUvsyncUpdate(microVU1); }
+// VUs run by the EE thread compile their cached programs between frames, one per vsync
+void recMicroVU0::Vsync() noexcept {
+	mVUvsyncUpdate(microVU0);
+	if (m_Reserved) mVUcachePreload(microVU0);
+}
+void recMicroVU1::Vsync() noexcept {
+	mVUvsyncUpdate(microVU1);
+	if (m_Reserved && !THREAD_VU1) mVUcachePreload(microVU1);
+}
 
 void recMicroVU0::Reserve() {
 	if (m_Reserved.exchange(1) == 0)
@@ -432,6 +545,14 @@ void recMicroVU1::SetCacheReserve(uint reserveInMegs) const {
 	mVUreserveCache(microVU1); // Need rec-reset after this
 }
 
+void recMicroVU1::CompileAhead(u32 startPC) {
+	if (m_Reserved) mVUcompileAhead(microVU1, startPC);
+}
+
+bool recMicroVU1::CompileCached() {
+	return m_Reserved && mVUcachePreload(microVU1);
+}
+
 void recMicroVU1::ResumeXGkick() {
 	pxAssert(m_Reserved); // please allocate me first! :|
 
@@ -19,8 +19,11 @@ using namespace x86Emitter;
 
 #include <deque>
 #include <algorithm>
+#include <unordered_map>
 #include <memory>
+#include <wx/ffile.h>
 #include "Common.h"
+#include "Elfheader.h"
 #include "VU.h"
 #include "MTVU.h"
 #include "GS.h"
@@ -138,13 +141,20 @@ struct microRange {
 	s32 end;   // End PC   (The opcode the block ends with)
 };
 
+struct microProgEntry {
+	microRegInfo pState;  // Pipeline state the entry point was compiled for
+	u32          startPC; // Entry point (in bytes)
+};
+
 #define mProgSize (0x4000/4)
 struct microProgram {
 	u32				   data [mProgSize];   // Holds a copy of the VU microProgram
 	microBlockManager* block[mProgSize/2]; // Array of Block Managers
 	std::deque<microRange>* ranges;			   // The ranges of the microProgram that have already been recompiled
+	std::vector<microProgEntry>* entries;	   // Entry points compiled from outside the program (kept by the program cache)
 	u32 startPC; // Start PC of this program
 	int idx;	 // Program index
+	u64 hash;	 // vuMicroHashOf(data), the program's key in microProgManager::index
 };
 
 typedef std::deque<microProgram*> microProgramList;
@@ -157,6 +167,8 @@ struct microProgramQuick {
 struct microProgManager {
 	microIR<mProgSize>	IRinfo;				// IR information
 	microProgramList*	prog [mProgSize/2];	// List of microPrograms indexed by startPC values
+	std::unordered_multimap<u64, microProgram*> index; // All microPrograms by the hash of their data
+	microProgStats		stats;				// Lookup counters
 	microProgramQuick	quick[mProgSize/2];	// Quick reference to valid microPrograms for current execution
 	microProgram*		cur;				// Pointer to currently running MicroProgram
 	int					total;				// Total Number of valid MicroPrograms
@@ -243,6 +255,9 @@ mVUop(mVUopL);
 // Private Functions
 extern void  mVUcacheProg (microVU& mVU, microProgram&  prog);
 extern void  mVUdeleteProg(microVU& mVU, microProgram*& prog);
+extern u64   mVUrangesHash(microVU& mVU, microProgram& prog);
+extern void  mVUindexProg (microVU& mVU, microProgram&  prog, u64 hash);
+extern void  mVUcompileAhead(microVU& mVU, u32 startPC);
 _mVUt extern void* mVUsearchProg(u32 startPC, uptr pState);
 extern void* __fastcall mVUexecuteVU0(u32 startPC, u32 cycles);
 extern void* __fastcall mVUexecuteVU1(u32 startPC, u32 cycles);
@@ -271,6 +286,7 @@ void sortVector(T& v) {
 #include "microVU_Tables.inl"
 #include "microVU_Flags.inl"
 #include "microVU_Branch.inl"
+#include "microVU_Cache.inl"
 #include "microVU_Compile.inl"
 #include "microVU_Execute.inl"
 #include "microVU_Macro.inl"
@@ -0,0 +1,339 @@
+/*  PCSX2 - PS2 Emulator for PCs
+ *  Copyright (C) 2002-2021  PCSX2 Dev Team
+ *
+ *  PCSX2 is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU Lesser General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  PCSX2 is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with PCSX2.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+//------------------------------------------------------------------
+// Micro VU - Program Cache
+//------------------------------------------------------------------
+// Keeps the microprograms a game ran in a file per game and VU (keyed by the ELF CRC), so
+// that the next session can compile them before the game runs them.  The host code itself is
+// not kept: it embeds the addresses of the VU registers, the dispatchers and the rec-cache,
+// none of which are stable between runs.  What is kept is each program's micro memory, the
+// ranges it was compiled for and its entry points with their pipeline state.
+//
+// Nothing is compiled on the execution path.  mVUcachePreload loads the file and then compiles
+// one cached program per call, and is only called when the VU is idle: by the MTVU thread when
+// its ring is drained and the EE isn't waiting for it, otherwise once per vsync.  Restored
+// programs are found by mVUsearchProg like any other program, by comparing their ranges with
+// the micro memory.  Programs the game compiled itself in the meantime are skipped.
+
+static const u32 mVUcacheMagic		= 0x47505655; // "UVPG"
+static const u32 mVUcacheVersion	= 1;		  // Bump whenever microRegInfo or microRange change
+static const u32 mVUcacheMaxProgs	= 512;		  // Per VU and game
+static const u32 mVUcacheMaxEntries	= 256;		  // Per program
+static const u32 mVUcacheMaxRanges	= 1024;		  // Per program, only used to reject bad files
+
+struct microCacheHeader {
+	u32 magic;
+	u32 version;
+	u32 crc;
+	u32 progCount;
+};
+
+struct microCacheProgHeader {
+	u32 startPC;	// mVU.prog.prog[] list the program belongs to
+	u32 rangeCount;
+	u32 entryCount;
+	u32 reserved;
+};
+
+struct microCachedProg {
+	u32 startPC;
+	u64 hash;	// mVUrangesHash() of the program
+	std::vector<microRange>		ranges;
+	std::vector<u32>			data;
+	std::vector<microProgEntry>	entries;
+};
+
+class microProgCache {
+	std::vector<microCachedProg> progs;
+	u32 next;		// First program preload hasn't looked at yet
+	bool loaded;	// The file was read (it is read by the first preload)
+	u32 restored;	// Programs compiled ahead of time this session
+
+	wxString getFilename(microVU& mVU) const {
+		return wxFileName(EmuConfig.RecCacheFolder.GetPath(), wxsFormat(L"VU%u_%08X.bin", mVU.index, crc)).GetFullPath();
+	}
+
+	// Same as mVUrangesHash(), for a program read from the file
+	static u64 rangesHash(const microCachedProg& cached) {
+		union {
+			u64 v64;
+			u32 v32[2];
+		} hash = {0};
+		for (const microRange& range : cached.ranges) {
+			for (int i = range.start / 4; i < range.end / 4; i++) {
+				hash.v32[0] -= cached.data[i];
+				hash.v32[1] ^= cached.data[i];
+			}
+		}
+		return hash.v64;
+	}
+
+	// The hash only narrows the search down, this is what makes two programs the same
+	static bool sameRanges(const microCachedProg& cached, const microProgram& prog) {
+		if (cached.ranges.size() != prog.ranges->size()) return false;
+		auto it = prog.ranges->begin();
+		for (const microRange& range : cached.ranges) {
+			if (range.start != it->start || range.end != it->end) return false;
+			if (memcmp(&cached.data[range.start / 4], &prog.data[range.start / 4], range.end - range.start)) return false;
+			++it;
+		}
+		return true;
+	}
+
+	// Whether prog was compiled from the same micro memory in all of cached's ranges
+	static bool covers(const microCachedProg& cached, const microProgram& prog) {
+		for (const microRange& range : cached.ranges) {
+			if (memcmp(&cached.data[range.start / 4], &prog.data[range.start / 4], range.end - range.start)) return false;
+		}
+		return true;
+	}
+
+	static void addEntry(std::vector<microProgEntry>& entries, const microProgEntry& entry) {
+		if (entries.size() >= mVUcacheMaxEntries) return;
+		for (const microProgEntry& e : entries) {
+			if (e.startPC == entry.startPC && !memcmp(&e.pState, &entry.pState, sizeof(microRegInfo)))
+				return;
+		}
+		entries.push_back(entry);
+	}
+
+public:
+	u32 crc;
+
+	microProgCache() : next(0), loaded(false), restored(0), crc(0) {}
+
+	// Remembers prog (called before programs are deleted, and when the cache is saved)
+	void keep(microVU& mVU, microProgram& prog) {
+		if (!crc || prog.ranges->empty() || prog.entries->empty()) return;
+		if (!loaded) { // Or saving would drop the programs of the file
+			loaded = true;
+			load(mVU);
+		}
+
+		const u64 hash = mVUrangesHash(mVU, prog);
+		for (microCachedProg& cached : progs) {
+			if (cached.startPC == prog.startPC && cached.hash == hash && sameRanges(cached, prog)) {
+				for (const microProgEntry& entry : *prog.entries)
+					addEntry(cached.entries, entry);
+				return;
+			}
+		}
+		if (progs.size() >= mVUcacheMaxProgs) return;
+
+		progs.emplace_back();
+		microCachedProg& cached = progs.back();
+		cached.startPC = prog.startPC;
+		cached.hash    = hash;
+		cached.ranges.assign(prog.ranges->begin(), prog.ranges->end());
+		cached.data.assign(prog.data, prog.data + mVU.progSize);
+		cached.entries = *prog.entries;
+	}
+
+	void load(microVU& mVU) {
+		const wxString filename = getFilename(mVU);
+		if (!wxFileExists(filename)) return;
+
+		wxFFile fp(filename, L"rb");
+		if (!fp.IsOpened()) return;
+
+		microCacheHeader header;
+		if (fp.Read(&header, sizeof(header)) != sizeof(header) || header.magic != mVUcacheMagic
+			|| header.version != mVUcacheVersion || header.crc != crc) {
+			log_cb(RETRO_LOG_WARN, "microVU%d: Ignoring outdated or foreign program cache %08X\n", mVU.index, crc);
+			return;
+		}
+
+		for (u32 i = 0; i < std::min(header.progCount, mVUcacheMaxProgs); i++) {
+			microCacheProgHeader ph;
+			if (fp.Read(&ph, sizeof(ph)) != sizeof(ph) || ph.startPC >= mVU.progSize / 2
+				|| ph.rangeCount > mVUcacheMaxRanges || ph.entryCount > mVUcacheMaxEntries) {
+				log_cb(RETRO_LOG_WARN, "microVU%d: Program cache %08X is damaged, discarding it\n", mVU.index, crc);
+				progs.clear();
+				return;
+			}
+
+			microCachedProg cached;
+			cached.startPC = ph.startPC;
+			cached.ranges.resize(ph.rangeCount);
+			cached.data.resize(mVU.progSize);
+			cached.entries.resize(ph.entryCount);
+
+			const size_t rangeBytes = ph.rangeCount * sizeof(microRange);
+			const size_t dataBytes  = mVU.progSize * sizeof(u32);
+			const size_t entryBytes = ph.entryCount * sizeof(microProgEntry);
+			bool ok = fp.Read(cached.ranges.data(), rangeBytes) == rangeBytes;
+			ok = ok && fp.Read(cached.data.data(), dataBytes) == dataBytes;
+			ok = ok && fp.Read(cached.entries.data(), entryBytes) == entryBytes;
+			for (const microRange& range : cached.ranges)
+				ok = ok && range.start >= 0 && range.start <= range.end && range.end <= (s32)mVU.microMemSize;
+			for (const microProgEntry& entry : cached.entries)
+				ok = ok && !(entry.startPC & 7) && entry.startPC <= mVU.microMemSize - 8;
+			if (!ok) {
+				log_cb(RETRO_LOG_WARN, "microVU%d: Program cache %08X is damaged, discarding it\n", mVU.index, crc);
+				progs.clear();
+				return;
+			}
+			cached.hash = rangesHash(cached);
+			progs.push_back(std::move(cached));
+		}
+
+		log_cb(RETRO_LOG_INFO, "microVU%d: Loaded %u cached programs for %08X\n", mVU.index, (u32)progs.size(), crc);
+	}
+
+	void save(microVU& mVU) {
+		if (progs.empty()) return;
+
+		wxFileName folder(EmuConfig.RecCacheFolder);
+		if (!folder.DirExists() && !folder.Mkdir(0777, wxPATH_MKDIR_FULL)) return;
+
+		const wxString filename = getFilename(mVU);
+		wxFFile fp(filename, L"wb");
+		if (!fp.IsOpened()) {
+			log_cb(RETRO_LOG_WARN, "microVU%d: Cannot write program cache %s\n", mVU.index, filename.ToUTF8().data());
+			return;
+		}
+
+		microCacheHeader header = { mVUcacheMagic, mVUcacheVersion, crc, (u32)progs.size() };
+		bool ok = fp.Write(&header, sizeof(header)) == sizeof(header);
+
+		for (const microCachedProg& cached : progs) {
+			microCacheProgHeader ph = { cached.startPC, (u32)cached.ranges.size(), (u32)cached.entries.size(), 0 };
+			const size_t rangeBytes = cached.ranges.size()  * sizeof(microRange);
+			const size_t dataBytes  = cached.data.size()    * sizeof(u32);
+			const size_t entryBytes = cached.entries.size() * sizeof(microProgEntry);
+			ok = ok && fp.Write(&ph, sizeof(ph)) == sizeof(ph);
+			ok = ok && fp.Write(cached.ranges.data(), rangeBytes) == rangeBytes;
+			ok = ok && fp.Write(cached.data.data(), dataBytes) == dataBytes;
+			ok = ok && fp.Write(cached.entries.data(), entryBytes) == entryBytes;
+		}
+
+		if (!ok) { // A partial file would only be rejected on the next load
+			fp.Close();
+			wxRemoveFile(filename);
+		}
+	}
+
+	// Reads the file on the first call, then compiles the next cached program into a new
+	// microProgram, from the micro memory it was cached with.  Returns false once there is
+	// nothing left to do.  Stops when the rec-cache runs low rather than forcing a reset.
+	bool preload(microVU& mVU) {
+		if (!crc) return false;
+		if (!loaded) {
+			loaded = true;
+			load(mVU);
+			return !progs.empty();
+		}
+		if (next >= progs.size()) return false;
+
+		while (next < progs.size()) {
+			if (mVU.prog.x86ptr >= mVU.prog.x86end) return false;
+
+			const microCachedProg& cached = progs[next++];
+			bool compiled = false;
+			for (microProgram* prog : *mVU.prog.prog[cached.startPC]) {
+				if (covers(cached, *prog)) { compiled = true; break; }
+			}
+			if (compiled) continue;
+
+			u8* micro = mVU.regs().Micro;
+			microProgram* cur = mVU.prog.cur;
+			const int isSame  = mVU.prog.isSame;
+			const int cleared = mVU.prog.cleared;
+
+			microProgram* prog = (microProgram*)_aligned_malloc(sizeof(microProgram), 64);
+			memset(prog, 0, sizeof(microProgram));
+			prog->idx     = mVU.prog.total++;
+			prog->ranges  = new std::deque<microRange>();
+			prog->entries = new std::vector<microProgEntry>();
+			prog->startPC = cached.startPC;
+			memcpy(prog->data, cached.data.data(), mVU.progSize * sizeof(u32));
+			mVUindexProg(mVU, *prog, vuMicroHashOf(prog->data, mVU.progSize));
+
+			// mVUcompile reads the instructions from the micro memory, so point it at the copy
+			xSetPtr(mVU.prog.x86ptr);
+			mVU.regs().Micro = (u8*)prog->data;
+			mVU.prog.cur     = prog;
+			mVU.prog.isSame  = 1;
+			for (const microProgEntry& entry : cached.entries) {
+				if (xGetPtr() >= mVU.prog.x86end) break;
+				mVUblockFetch(mVU, entry.startPC, (uptr)&entry.pState);
+			}
+			mVU.regs().Micro = micro;
+			mVU.prog.x86ptr  = xGetPtr();
+			mVU.prog.cur     = cur;
+			mVU.prog.isSame  = isSame;
+			mVU.prog.cleared = cleared;
+
+			if (prog->ranges->empty()) {
+				mVUdeleteProg(mVU, prog);
+				continue;
+			}
+			mVU.prog.prog[prog->startPC]->push_back(prog);
+			restored++;
+			break;
+		}
+
+		if (next < progs.size()) return true;
+		if (restored)
+			log_cb(RETRO_LOG_INFO, "microVU%d: Compiled %u cached programs ahead of time\n", mVU.index, restored);
+		return false;
+	}
+
+	// Saves the programs of the current game and switches to the one with the given CRC
+	void open(microVU& mVU, u32 newCrc) {
+		for (u32 i = 0; i < (mVU.progSize / 2); i++) {
+			if (!mVU.prog.prog[i]) continue;
+			for (microProgram* prog : *mVU.prog.prog[i])
+				keep(mVU, *prog);
+		}
+		if (crc) save(mVU);
+
+		progs.clear();
+		next = 0;
+		loaded = false;
+		restored = 0;
+		crc = newCrc;
+		if (!EmuConfig.RecCacheFolder.IsOk())
+			crc = 0;
+	}
+};
+
+static microProgCache mVUprogCache[2];
+
+// Records an entry point of the current program, so that the cache can compile it again
+__fi void mVUcacheEntry(microVU& mVU, u32 startPC, uptr pState) {
+	if (!mVUprogCache[mVU.index].crc) return;
+	std::vector<microProgEntry>& entries = *mVU.prog.cur->entries;
+	if (entries.size() >= mVUcacheMaxEntries) return;
+	entries.emplace_back();
+	memcpy(&entries.back().pState, (void*)pState, sizeof(microRegInfo));
+	entries.back().startPC = startPC;
+}
+
+// Switches the program cache to the running game when it changes
+__fi void mVUcacheCheck(microVU& mVU) {
+	const u32 crc = EmuConfig.RecBlockCache ? ElfCRC : 0;
+	if (crc != mVUprogCache[mVU.index].crc)
+		mVUprogCache[mVU.index].open(mVU, crc);
+}
+
+// Compiles one more program of the cache while the VU is idle (see the top of this file).
+// Returns false when there is nothing left to compile.
+__fi bool mVUcachePreload(microVU& mVU) {
+	return mVUprogCache[mVU.index].preload(mVU);
+}
@@ -779,7 +779,7 @@ void* mVUcompile(microVU& mVU, u32 startPC, uptr pState)
 __fi void* mVUentryGet(microVU& mVU, microBlockManager* block, u32 startPC, uptr pState) {
 	microBlock* pBlock = block->search((microRegInfo*)pState);
 	if (pBlock) return pBlock->x86ptrStart;
-	else	 {  return mVUcompile(mVU, startPC, pState);}
+	else	 {  mVUcacheEntry(mVU, startPC, pState); return mVUcompile(mVU, startPC, pState);}
 }
 
  // Search for Existing Compiled Block (if found, return x86ptr; else, compile and return x86ptr)
@@ -94,6 +94,23 @@ static const char microOpcodeName[][16] = {
 	"EEXP", "XITOP", "XTOP", "XGKICK"
 };
 
+// Counters of the microprogram lookups done by mVUsearchProg
+struct microProgStats {
+	u64 hashHits;	// Found through the content hash index (one compare)
+	u64 hashMisses;	// Not in the index, so the startPC's program list was scanned
+	u64 scanHits;	// Found by the scan (its ranges match, the rest of micro memory doesn't)
+	u64 compares;	// Program compares done by both
+	u64 compiledAhead; // Entry points compiled by mVUcompileAhead
+
+	__fi void Reset() { memzero(*this); }
+	void Print(int index) const {
+		if (!hashHits && !hashMisses) return;
+		log_cb(RETRO_LOG_INFO, "microVU%d: Program lookups: %llu hash hits, %llu misses (%llu found by scan), %llu compares, %llu entries compiled ahead\n",
+			index, (unsigned long long)hashHits, (unsigned long long)hashMisses, (unsigned long long)scanHits, (unsigned long long)compares,
+			(unsigned long long)compiledAhead);
+	}
+};
+
 struct microProfiler {
 	__fi void Reset(int _index) {}
 	__fi void EmitOp(microOpcode op) {}
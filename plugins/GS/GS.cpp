@@ -24,6 +24,7 @@
 #include "Renderers/SW/GSRendererSW.h"
 #include "Renderers/Null/GSRendererNull.h"
 #include "Renderers/Null/GSDeviceNull.h"
+#include "Renderers/SW/GSDeviceSW.h"
 #include "Renderers/OpenGL/GSDeviceOGL.h"
 #include "Renderers/OpenGL/GSRendererOGL.h"
 
@@ -191,6 +192,10 @@ static int _GSopen(const char* title, GSRendererType renderer, int threads = -1)
 			dev = new GSDeviceOGL();
 			renderer_name = "Software";
 			break;
+		case GSRendererType::SW:
+			dev = new GSDeviceSW();
+			renderer_name = "Software (CPU)";
+			break;
 		case GSRendererType::Null:
 			dev = new GSDeviceNull();
 			renderer_name = "Null";
@@ -219,6 +224,7 @@ static int _GSopen(const char* title, GSRendererType renderer, int threads = -1)
 				s_gs = (GSRenderer*)new GSRendererOGL();
 				break;
 			case GSRendererType::OGL_SW:
+			case GSRendererType::SW:
 				s_gs = new GSRendererSW(threads);
 				break;
 			case GSRendererType::Null:
@@ -258,8 +264,16 @@ EXPORT_C_(int) GSopen2(u32 flags)
 			log_cb(RETRO_LOG_INFO, "Selected Renderer: DX1011_HW\n" );
 			break;
 		case RETRO_HW_CONTEXT_NONE:
-			theApp.SetCurrentRendererType(GSRendererType::Null);
-			log_cb(RETRO_LOG_INFO, "Selected Renderer: NULL\n");
+			if (! std::strcmp(option_value(STRING_PCSX2_OPT_RENDERER, KeyOptionString::return_type), "Software"))
+			{
+				theApp.SetCurrentRendererType(GSRendererType::SW);
+				log_cb(RETRO_LOG_INFO, "Selected Renderer: SW\n");
+			}
+			else
+			{
+				theApp.SetCurrentRendererType(GSRendererType::Null);
+				log_cb(RETRO_LOG_INFO, "Selected Renderer: NULL\n");
+			}
 			break;
 		default:
 			if (! std::strcmp(option_value(STRING_PCSX2_OPT_RENDERER, KeyOptionString::return_type), "Software"))
@@ -290,6 +304,9 @@ EXPORT_C_(int) GSopen2(u32 flags)
 			case GSRendererType::OGL_SW:
 				current_renderer = GSRendererType::OGL_HW;
 				break;
+			case GSRendererType::SW:
+				// no GL context to switch to
+				break;
 			case GSRendererType::OGL_HW:
 				current_renderer = GSRendererType::OGL_SW;
 				break;
@@ -232,6 +232,7 @@ enum class GSRendererType : int8_t
 	Null = 11,
 	OGL_HW,
 	OGL_SW,
+	SW,       // SW renderer on a CPU-only device, no GL context
 
 #ifdef _WIN32
 	Default = Undefined
@@ -0,0 +1,249 @@
+/*
+ *	Copyright (C) 2007-2009 Gabest
+ *	http://www.gabest.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+
+#include "GSDeviceSW.h"
+
+#include <vector>
+#include <libretro.h>
+
+extern retro_video_refresh_t video_cb;
+
+// RGBA8 (as read back from GS memory) to the frontend's XRGB8888.
+static __forceinline u32 RGBAToXRGB(u32 c)
+{
+	return ((c & 0xff) << 16) | (c & 0xff00) | ((c >> 16) & 0xff);
+}
+
+// Blends s over d, a in [0, 256], both red/blue lanes at once.
+static __forceinline u32 BlendXRGB(u32 s, u32 d, u32 a)
+{
+	const u32 rb = (((s & 0xff00ff) * a + (d & 0xff00ff) * (256 - a)) >> 8) & 0xff00ff;
+	const u32 g  = (((s & 0x00ff00) * a + (d & 0x00ff00) * (256 - a)) >> 8) & 0x00ff00;
+
+	return rb | g;
+}
+
+bool GSDeviceSW::Create()
+{
+	if(!GSDevice::Create())
+		return false;
+
+	Reset(1, 1);
+
+	return true;
+}
+
+bool GSDeviceSW::Reset(int w, int h)
+{
+	return GSDevice::Reset(w, h);
+}
+
+GSTexture* GSDeviceSW::CreateSurface(int type, int w, int h, int format)
+{
+	return new GSTextureSW(type, w, h);
+}
+
+void GSDeviceSW::Present(const GSVector4i& r, int shader)
+{
+	// DoMerge already wrote XRGB8888, so the output texture is handed over as it is.
+	// It stays untouched until the next vsync, which happens in the next retro_run.
+
+	GSTexture::GSMap m;
+
+	if(m_current && m_current->Map(m))
+	{
+		video_cb(m.bits, m_current->GetWidth(), m_current->GetHeight(), m.pitch);
+
+		m_current->Unmap();
+	}
+}
+
+void GSDeviceSW::Fill(GSTexture* dTex, u32 c)
+{
+	GSTexture::GSMap m;
+
+	if(dTex->Map(m))
+	{
+		for(int y = 0; y < dTex->GetHeight(); y++)
+		{
+			u32* RESTRICT d = (u32*)(m.bits + y * m.pitch);
+
+			for(int x = 0; x < dTex->GetWidth(); x++)
+			{
+				d[x] = c;
+			}
+		}
+
+		dTex->Unmap();
+	}
+}
+
+void GSDeviceSW::MergeRect(GSTexture* sTex, const GSVector4& sRect, GSTexture* dTex, const GSVector4& dRect, MergeMode mode, u32 alpha)
+{
+	const int left   = std::max<int>(0, (int)(dRect.x + 0.5f));
+	const int top    = std::max<int>(0, (int)(dRect.y + 0.5f));
+	const int right  = std::min<int>(dTex->GetWidth(), (int)(dRect.z + 0.5f));
+	const int bottom = std::min<int>(dTex->GetHeight(), (int)(dRect.w + 0.5f));
+
+	if(left >= right || top >= bottom)
+		return;
+
+	const int sw = sTex->GetWidth();
+	const int sh = sTex->GetHeight();
+
+	// point sampling, same mapping as the hw StretchRect with linear off
+	const float su = sRect.x * sw;
+	const float sv = sRect.y * sh;
+	const float du = (sRect.z - sRect.x) * sw / (dRect.z - dRect.x);
+	const float dv = (sRect.w - sRect.y) * sh / (dRect.w - dRect.y);
+
+	std::vector<int> cols(right - left);
+
+	for(int x = left; x < right; x++)
+	{
+		cols[x - left] = std::min<int>(std::max<int>((int)(su + (x + 0.5f - dRect.x) * du), 0), sw - 1);
+	}
+
+	if(mode == Merge_BlendConst)
+	{
+		alpha += alpha >> 7;
+	}
+
+	GSTexture::GSMap sm, dm;
+
+	if(!sTex->Map(sm))
+		return;
+
+	if(!dTex->Map(dm))
+	{
+		sTex->Unmap();
+		return;
+	}
+
+	for(int y = top; y < bottom; y++)
+	{
+		const int sy = std::min<int>(std::max<int>((int)(sv + (y + 0.5f - dRect.y) * dv), 0), sh - 1);
+
+		const u32* RESTRICT s = (const u32*)(sm.bits + sy * sm.pitch);
+		u32* RESTRICT d = (u32*)(dm.bits + y * dm.pitch);
+
+		for(int x = left; x < right; x++)
+		{
+			const u32 c = s[cols[x - left]];
+
+			switch(mode)
+			{
+				case Merge_Copy:
+					d[x] = RGBAToXRGB(c);
+					break;
+				case Merge_BlendConst:
+					d[x] = BlendXRGB(RGBAToXRGB(c), d[x], alpha);
+					break;
+				case Merge_BlendSrc:
+				{
+					u32 a = std::min<u32>((c >> 24) << 1, 255);
+					d[x] = BlendXRGB(RGBAToXRGB(c), d[x], a + (a >> 7));
+					break;
+				}
+			}
+		}
+	}
+
+	dTex->Unmap();
+	sTex->Unmap();
+}
+
+void GSDeviceSW::DoMerge(GSTexture* sTex[3], GSVector4* sRect, GSTexture* dTex, GSVector4* dRect, const GSRegPMODE& PMODE, const GSRegEXTBUF& EXTBUF, const GSVector4& c)
+{
+	// Same steps as the hw devices, minus the feedback write (sTex[2]), which isn't emulated here.
+	// The result is written as XRGB8888 so that Present doesn't have to convert it.
+
+	const u32 r = (u32)(c.x * 255 + 0.5f);
+	const u32 g = (u32)(c.y * 255 + 0.5f);
+	const u32 b = (u32)(c.z * 255 + 0.5f);
+
+	Fill(dTex, (r << 16) | (g << 8) | b);
+
+	if(sTex[1] && PMODE.SLBG == 0)
+	{
+		// 2nd output is enabled and selected. Copy it to destination so we can blend it with 1st output
+		MergeRect(sTex[1], sRect[1], dTex, dRect[1], Merge_Copy, 0);
+	}
+
+	if(sTex[0])
+	{
+		// 1st output is enabled. It must be blended
+		MergeRect(sTex[0], sRect[0], dTex, dRect[0], PMODE.MMOD == 1 ? Merge_BlendConst : Merge_BlendSrc, PMODE.ALP);
+	}
+}
+
+void GSDeviceSW::DoInterlace(GSTexture* sTex, GSTexture* dTex, int shader, bool linear, float yoffset)
+{
+	const int w  = std::min<int>(sTex->GetWidth(), dTex->GetWidth());
+	const int sh = sTex->GetHeight();
+	const int dh = dTex->GetHeight();
+
+	GSTexture::GSMap sm, dm;
+
+	if(!sTex->Map(sm))
+		return;
+
+	if(!dTex->Map(dm))
+	{
+		sTex->Unmap();
+		return;
+	}
+
+	for(int y = 0; y < dh; y++)
+	{
+		// 0: weave, odd lines; 1: weave, even lines; 2: blend; 3: bob
+		if((shader == 0 && !(y & 1)) || (shader == 1 && (y & 1)))
+			continue;
+
+		u32* RESTRICT d = (u32*)(dm.bits + y * dm.pitch);
+
+		if(shader == 2)
+		{
+			const u32* RESTRICT s0 = (const u32*)(sm.bits + std::max<int>(y - 1, 0) * sm.pitch);
+			const u32* RESTRICT s1 = (const u32*)(sm.bits + std::min<int>(y, sh - 1) * sm.pitch);
+			const u32* RESTRICT s2 = (const u32*)(sm.bits + std::min<int>(y + 1, sh - 1) * sm.pitch);
+
+			for(int x = 0; x < w; x++)
+			{
+				const u32 rb = (((s0[x] & 0xff00ff) + ((s1[x] & 0xff00ff) << 1) + (s2[x] & 0xff00ff)) >> 2) & 0xff00ff;
+				const u32 g  = (((s0[x] & 0x00ff00) + ((s1[x] & 0x00ff00) << 1) + (s2[x] & 0x00ff00)) >> 2) & 0x00ff00;
+
+				d[x] = rb | g;
+			}
+		}
+		else
+		{
+			const float fy = shader == 3 ? y - yoffset : (float)y;
+			const int sy = std::min<int>(std::max<int>((int)((fy + 0.5f) * sh / dh), 0), sh - 1);
+
+			memcpy(d, sm.bits + sy * sm.pitch, w * sizeof(u32));
+		}
+	}
+
+	dTex->Unmap();
+	sTex->Unmap();
+}
@@ -27,6 +27,7 @@
 #include "GSVertexSW.h"
 #include "../../GSAlignedClass.h"
 #include "../../GSThread_CXX11.h"
+#include "Utilities/SubsystemTiming.h"
 
 class alignas(32) GSRasterizerData : public GSAlignedClass<32>
 {
@@ -193,7 +194,10 @@ public:
 			rl->m_r.push_back(std::unique_ptr<GSRasterizer>(new GSRasterizer(new DS(), i, threads)));
 			auto &r = *rl->m_r[i];
 			rl->m_workers.push_back(std::unique_ptr<GSWorker>(new GSWorker(
-				[&r](std::shared_ptr<GSRasterizerData> &item) { r.Draw(item.get()); })));
+				[&r](std::shared_ptr<GSRasterizerData> &item) {
+					SubsystemTiming::Scope timing(SubsystemTiming::GSWorkers);
+					r.Draw(item.get());
+				})));
 		}
 
 		return rl;